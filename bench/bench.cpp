@@ -0,0 +1,248 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include "mmu.h"
+#include "pagetable.h"
+#include "tlb.h"
+#include "simulator.h"
+
+/*
+ * Microbenchmarks for the MMU and page table hot paths
+ * Calls are timed in batches of batch_size and each batch gives one sample of the time per call, so the
+ * clock is read twice per batch rather than twice per call. Percentiles are over those samples.
+ * Inputs are worked out before the timed loops so that only the calls are inside a batch.
+ * Results are written to stdout as CSV, one row per benchmark and configuration:
+ * benchmark,page_table,page_size,processes,variables,operations,ns_per_op,p50_ns,p90_ns,p99_ns,max_ns
+ * Page table benchmarks run with every page table layout, heap benchmarks with the flat one
+ */
+
+const PageTableLayout layouts[] = {PAGE_TABLE_FLAT, PAGE_TABLE_TWO_LEVEL, PAGE_TABLE_THREE_LEVEL};
+const char *layout_names[] = {"flat", "two-level", "three-level"};
+const int page_sizes[] = {1024, 4096, 32768};
+const int process_counts[] = {1, 16, 128};
+const int variable_counts[] = {64, 1024};
+// translations timed for each configuration
+const int lookups = 200000;
+// calls timed together as one sample
+const int batch_size = 64;
+
+typedef struct BenchConfig {
+    PageTableLayout layout;
+    int page_size;
+    int processes;
+    int variables;
+} BenchConfig;
+
+// Timings of one benchmark, in nanoseconds per call, one sample per batch of calls
+class Samples {
+private:
+    std::vector<double> _ns;
+    std::chrono::steady_clock::time_point _start;
+    int _batch_calls; // calls in the batch being timed
+    long _calls;
+    double _total_ns;
+
+    // Ends the batch being timed
+    void record() {
+        if (_batch_calls == 0) {
+            return;
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _start).count();
+        _ns.push_back(ns / _batch_calls);
+        _total_ns += ns;
+        _calls += _batch_calls;
+        _batch_calls = 0;
+    }
+
+public:
+    Samples(long expected) {
+        _ns.reserve(expected / batch_size + 1);
+        _batch_calls = 0;
+        _calls = 0;
+        _total_ns = 0;
+    }
+
+    // Call before each timed call, the clock is only read when a batch starts
+    void start() {
+        if (_batch_calls == 0) {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+
+    // Call after each timed call, the clock is only read when a batch is full
+    void stop() {
+        if (++_batch_calls == batch_size) {
+            record();
+        }
+    }
+
+    // Prints the CSV row, sorts the samples
+    void report(const char *benchmark, BenchConfig *config) {
+        record();
+        if (_ns.empty()) {
+            return;
+        }
+        std::sort(_ns.begin(), _ns.end());
+        std::cout << benchmark << "," << layout_names[config->layout] << "," << config->page_size << "," << config->processes << "," << config->variables
+                  << "," << _calls << "," << _total_ns / _calls << "," << percentile(50) << ","
+                  << percentile(90) << "," << percentile(99) << "," << _ns.back() << '\n';
+    }
+
+    double percentile(int p) {
+        return _ns[(_ns.size() - 1) * p / 100];
+    }
+};
+
+static uint64_t nextRandom(uint64_t *state) {
+    // xorshift64
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/*
+ * Page table: map variables pages in every process, translate random addresses on them, unmap them again
+ */
+static void benchPageTable(BenchConfig *config) {
+    Tlb tlb(16, 4, TLB_LRU);
+    PageTable pageTable(config->page_size, &tlb, 1, config->layout);
+    uint64_t state = 88172645463325252ULL;
+    long entries = (long)config->processes * config->variables;
+
+    Samples add(entries);
+    for (int page = 0; page < config->variables; page++) {
+        for (int pid = 0; pid < config->processes; pid++) {
+            add.start();
+            pageTable.addEntry(1024 + pid, page);
+            add.stop();
+        }
+    }
+    add.report("addEntry", config);
+
+    std::vector<uint32_t> pids(lookups);
+    std::vector<int> virtual_addresses(lookups);
+    for (int i = 0; i < lookups; i++) {
+        pids[i] = 1024 + nextRandom(&state) % config->processes;
+        virtual_addresses[i] = nextRandom(&state) % ((long)config->variables * config->page_size);
+    }
+    Samples translate(lookups);
+    long checksum = 0;
+    for (int i = 0; i < lookups; i++) {
+        translate.start();
+        checksum += pageTable.getPhysicalAddress(pids[i], virtual_addresses[i]);
+        translate.stop();
+    }
+    translate.report("getPhysicalAddress", config);
+
+    Samples remove(entries);
+    for (int page = 0; page < config->variables; page++) {
+        for (int pid = 0; pid < config->processes; pid++) {
+            remove.start();
+            pageTable.removeEntry(1024 + pid, page);
+            remove.stop();
+        }
+    }
+    remove.report("removeEntry", config);
+
+    if (checksum == 0) {
+        std::cerr << "no translations" << '\n';
+    }
+}
+
+/*
+ * Heap: allocate variables of random sizes in every process, then free every other one (no neighbours
+ * to merge with), then free the rest, each of which is merged with the free blocks on both sides
+ */
+static void benchHeap(BenchConfig *config) {
+    Tlb tlb(16, 4, TLB_LRU);
+    PageTable pageTable(config->page_size, &tlb, 1, config->layout);
+    Mmu mmu(67108864, FIRST_FIT, 1);
+    uint64_t state = 88172645463325252ULL;
+    long variables = (long)config->processes * config->variables;
+
+    std::vector<std::string> names;
+    for (int i = 0; i < config->variables; i++) {
+        names.push_back("v" + std::to_string(i));
+    }
+    std::vector<int> pids;
+    for (int i = 0; i < config->processes; i++) {
+        pids.push_back(mmu.createProcess());
+    }
+
+    std::vector<int> sizes(variables);
+    for (long i = 0; i < variables; i++) {
+        sizes[i] = 1 + nextRandom(&state) % 4096;
+    }
+    Samples add(variables);
+    for (int i = 0; i < config->variables; i++) {
+        for (int p = 0; p < pids.size(); p++) {
+            add.start();
+            mmu.addVariableToProcess(pids[p], names[i], sizes[(long)i * pids.size() + p], TYPE_CHAR);
+            add.stop();
+        }
+    }
+    add.report("addVariableToProcess", config);
+
+    // give the variables pages so free() has entries to remove
+    for (int p = 0; p < pids.size(); p++) {
+        Process *process = mmu.getProcess(pids[p]);
+        for (Variable *var = process->first_variable; var != NULL; var = var->next) {
+            if (!var->is_free) {
+                int first_page;
+                int last_page;
+                getPageRange(var->virtual_address, var->size, config->page_size, &first_page, &last_page);
+                for (int page = first_page; page <= last_page; page++) {
+                    pageTable.addEntry(pids[p], page);
+                }
+            }
+        }
+    }
+
+    Samples release(variables / 2 + pids.size());
+    for (int i = 0; i < config->variables; i += 2) {
+        for (int p = 0; p < pids.size(); p++) {
+            release.start();
+            free(pids[p], names[i], &mmu, &pageTable, config->page_size);
+            release.stop();
+        }
+    }
+    release.report("free", config);
+
+    // the remaining variables are not moved by freeing the ones before them, so they can be looked up first
+    std::vector<Variable *> remaining;
+    for (int i = 1; i < config->variables; i += 2) {
+        for (int p = 0; p < pids.size(); p++) {
+            remaining.push_back(mmu.getVariableFromProcess(pids[p], names[i]));
+        }
+    }
+    Samples join(remaining.size());
+    for (int i = 0; i < remaining.size(); i++) {
+        join.start();
+        mmu.freeVariable(pids[i % pids.size()], remaining[i]);
+        join.stop();
+    }
+    join.report("joinFreeSpace", config);
+}
+
+int main() {
+    std::ios::sync_with_stdio(false);
+    std::cout << "benchmark,page_table,page_size,processes,variables,operations,ns_per_op,p50_ns,p90_ns,p99_ns,max_ns"
+              << '\n';
+    for (int page_size : page_sizes) {
+        for (int processes : process_counts) {
+            for (int variables : variable_counts) {
+                for (PageTableLayout layout : layouts) {
+                    BenchConfig config = {layout, page_size, processes, variables};
+                    benchPageTable(&config);
+                }
+                BenchConfig config = {PAGE_TABLE_FLAT, page_size, processes, variables};
+                benchHeap(&config);
+            }
+        }
+    }
+    return 0;
+}
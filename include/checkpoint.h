@@ -0,0 +1,77 @@
+#ifndef __CHECKPOINT_H_
+#define __CHECKPOINT_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+struct Simulator;
+
+/*
+ * Checkpoint of the whole simulator
+ * A CheckpointHeader, then the state of the MMU, page table and physical
+ * memory as fixed size values in the byte order of the machine that wrote
+ * them. The frame image starts at a page aligned offset and holds every frame
+ * at its own place, frames that were never written are holes in the file.
+ * Loading maps the image over physical memory instead of reading it, so the
+ * OS only reads a frame in when it is first touched and writes stay private.
+ */
+
+typedef struct CheckpointHeader {
+    char magic[8]; // "MEMSIMCP"
+    uint32_t version;
+    int32_t page_size;
+    int64_t memory_size;
+    int32_t large_pages;
+    int32_t reserved;
+    int64_t state_size; // bytes of state right after the header
+    int64_t image_offset; // where the frame image starts
+} CheckpointHeader;
+
+// Appends state values to a checkpoint, isOk turns false once a write fails
+class CheckpointWriter {
+private:
+    FILE *_file;
+    bool _ok;
+
+public:
+    CheckpointWriter(FILE *file);
+
+    template<typename T>
+    void write(T value) {
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeBytes(const void *data, long length);
+
+    void writeString(const std::string &value);
+
+    bool isOk();
+};
+
+// Reads state values back from a mapped checkpoint, every read fails once one has run past the end
+class CheckpointReader {
+private:
+    const uint8_t *_data;
+    long _size;
+    long _position;
+    bool _ok;
+
+public:
+    CheckpointReader(const uint8_t *data, long size);
+
+    template<typename T>
+    bool read(T *value) {
+        return readBytes(value, sizeof(T));
+    }
+
+    bool readBytes(void *data, long length);
+
+    bool readString(std::string *value);
+};
+
+bool saveCheckpoint(const char *path, Simulator *sim, std::string *error);
+
+bool loadCheckpoint(const char *path, Simulator *sim, std::string *error);
+
+#endif // __CHECKPOINT_H_
@@ -0,0 +1,33 @@
+#ifndef __COMMAND_H_
+#define __COMMAND_H_
+
+#include <string>
+#include <vector>
+
+/*
+ * A command line split in place
+ * The line buffer is modified so that every token is null terminated,
+ * name and arguments point into that buffer rather than owning copies
+ */
+typedef struct CommandLine {
+    char *name;
+    std::vector<char *> arguments;
+} CommandLine;
+
+void tokenizeCommand(char *line, CommandLine *command);
+
+char *splitToken(char *token, char delimiter);
+
+std::string joinCommand(CommandLine *command);
+
+bool parseInt(const char *text, int *value);
+
+bool parseLong(const char *text, long *value);
+
+bool parseSize(const char *text, long *value);
+
+bool parseFloat(const char *text, float *value);
+
+bool parseDouble(const char *text, double *value);
+
+#endif // __COMMAND_H_
@@ -0,0 +1,30 @@
+#ifndef __CONDITIONALLOCK_H_
+#define __CONDITIONALLOCK_H_
+
+#include <mutex>
+
+/*
+ * Scoped lock that only takes the mutex when it is enabled
+ * Structures shared between client threads enable it in concurrent mode,
+ * so the single-threaded simulator does not pay for locking
+ */
+class ConditionalLock {
+private:
+    std::mutex *_mutex;
+
+public:
+    ConditionalLock(std::mutex &mutex, bool enabled) {
+        _mutex = enabled ? &mutex : NULL;
+        if (_mutex != NULL) {
+            _mutex->lock();
+        }
+    }
+
+    ~ConditionalLock() {
+        if (_mutex != NULL) {
+            _mutex->unlock();
+        }
+    }
+};
+
+#endif // __CONDITIONALLOCK_H_
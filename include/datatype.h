@@ -0,0 +1,101 @@
+#ifndef __DATATYPE_H_
+#define __DATATYPE_H_
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "command.h"
+
+// Element type of a variable
+enum DataType : uint8_t {
+    TYPE_NONE, // <FREE_SPACE> blocks
+    TYPE_CHAR,
+    TYPE_SHORT,
+    TYPE_INT,
+    TYPE_FLOAT,
+    TYPE_LONG,
+    TYPE_DOUBLE,
+    DATA_TYPE_COUNT
+};
+
+extern const char *data_type_names[DATA_TYPE_COUNT];
+
+extern const int data_type_sizes[DATA_TYPE_COUNT];
+
+DataType parseDataType(const std::string &name);
+
+/*
+ * What set and print need to know about each type: the C++ type values are
+ * stored as, how one is parsed from a command argument and how it is printed
+ * Code that handles values is instantiated once per type with this table,
+ * so the type is only looked at once per command
+ */
+template<DataType type>
+struct DataTypeTraits;
+
+template<>
+struct DataTypeTraits<TYPE_CHAR> {
+    typedef char value_type;
+
+    // only the first character of the argument is used
+    static bool parse(const char *text, char *value) {
+        *value = text[0];
+        return true;
+    }
+};
+
+template<>
+struct DataTypeTraits<TYPE_SHORT> {
+    typedef short value_type;
+
+    static bool parse(const char *text, short *value) {
+        int parsed;
+        bool valid = parseInt(text, &parsed);
+        *value = parsed;
+        return valid;
+    }
+};
+
+template<>
+struct DataTypeTraits<TYPE_INT> {
+    typedef int value_type;
+
+    static bool parse(const char *text, int *value) {
+        return parseInt(text, value);
+    }
+};
+
+template<>
+struct DataTypeTraits<TYPE_FLOAT> {
+    typedef float value_type;
+
+    static bool parse(const char *text, float *value) {
+        return parseFloat(text, value);
+    }
+};
+
+template<>
+struct DataTypeTraits<TYPE_LONG> {
+    typedef long value_type;
+
+    static bool parse(const char *text, long *value) {
+        return parseLong(text, value);
+    }
+};
+
+template<>
+struct DataTypeTraits<TYPE_DOUBLE> {
+    typedef double value_type;
+
+    static bool parse(const char *text, double *value) {
+        return parseDouble(text, value);
+    }
+};
+
+// Values are printed the way the stream prints their C++ type, chars as characters
+template<DataType type>
+void formatValue(std::ostream &out, typename DataTypeTraits<type>::value_type value) {
+    out << value;
+}
+
+#endif // __DATATYPE_H_
@@ -0,0 +1,47 @@
+#ifndef __FRAMEALLOCATOR_H_
+#define __FRAMEALLOCATOR_H_
+
+#include <cstdint>
+#include <vector>
+#include "checkpoint.h"
+
+/*
+ * Hands out frame numbers lowest-free-first.
+ * Frames are tracked in a word-packed bitmap (bit set = frame in use) with a
+ * summary bitmap on top (bit set = bitmap word is full), so finding the lowest
+ * free frame only has to look at one summary bit per 4096 frames.
+ * Runs of frames for large pages are allocated aligned to their length.
+ */
+class FrameAllocator {
+private:
+    std::vector<uint64_t> _words;
+    std::vector<uint64_t> _full;
+    int _used;
+
+    void markAllocated(int frame);
+
+public:
+    FrameAllocator();
+
+    ~FrameAllocator();
+
+    int allocate();
+
+    int allocateAligned(int count);
+
+    void release(int frame);
+
+    void releaseRange(int first_frame, int count);
+
+    bool isAllocated(int frame);
+
+    int getUsedCount();
+
+    void clear();
+
+    void save(CheckpointWriter *writer);
+
+    bool load(CheckpointReader *reader);
+};
+
+#endif // __FRAMEALLOCATOR_H_
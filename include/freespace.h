@@ -0,0 +1,76 @@
+#ifndef __FREESPACE_H_
+#define __FREESPACE_H_
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include "objectpool.h"
+
+struct Variable;
+
+// How a process's heap picks the free block a new variable goes in
+enum AllocationPolicy {
+    FIRST_FIT, // lowest addressed block that fits
+    NEXT_FIT,  // first block that fits at or after the last allocation, wrapping around
+    BEST_FIT,  // smallest block that fits
+    WORST_FIT  // largest block
+};
+
+// Node of the address ordered tree, with the size of the largest block under it
+typedef struct FreeSpaceNode {
+    Variable *block;
+    int address;
+    int size;
+    int max_size; // largest size in this node's subtree
+    uint32_t priority;
+    struct FreeSpaceNode *left;
+    struct FreeSpaceNode *right;
+} FreeSpaceNode;
+
+/*
+ * Index of a process's <FREE_SPACE> blocks, kept both by address and by size
+ * The address index is a treap whose nodes know the largest block below them,
+ * so the lowest addressed block that fits at or after an address is found by
+ * one descent instead of a walk over the free blocks.
+ * Blocks must be removed before their address or size changes and inserted again after
+ */
+class FreeSpace {
+private:
+    FreeSpaceNode *_root;
+    ObjectPool<FreeSpaceNode> _nodes;
+    std::map<std::pair<int, int>, Variable *> _by_size; // <size, address>
+    int _block_count;
+    long _free_bytes;
+    int _next_fit_address;
+
+    static void update(FreeSpaceNode *node);
+
+    static void split(FreeSpaceNode *node, int address, FreeSpaceNode **before, FreeSpaceNode **after);
+
+    static FreeSpaceNode *merge(FreeSpaceNode *before, FreeSpaceNode *after);
+
+    static FreeSpaceNode *findFirst(FreeSpaceNode *node, int address, int size);
+
+public:
+    FreeSpace();
+
+    ~FreeSpace();
+
+    void insert(Variable *block);
+
+    void remove(Variable *block);
+
+    Variable *find(int size, AllocationPolicy policy);
+
+    int getBlockCount();
+
+    long getFreeBytes();
+
+    int getLargestBlock();
+
+    int getNextFitAddress();
+
+    void setNextFitAddress(int address);
+};
+
+#endif // __FREESPACE_H_
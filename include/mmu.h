@@ -5,51 +5,114 @@
 #include <iomanip>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "freespace.h"
+#include "checkpoint.h"
+#include "datatype.h"
+#include "objectpool.h"
 
 typedef struct Variable {
-    std::string name;
+    const std::string *name; // key of the process's name index, shared by every <FREE_SPACE> block
     int virtual_address;
     int size;
-    std::string type; // char, short, int/float, long/double
+    DataType type; // TYPE_NONE for <FREE_SPACE> blocks
+    bool is_free; // true for <FREE_SPACE> blocks
+    // bytes of the block before and after the variable, shared segments take whole pages of their own
+    int padding_before;
+    int padding_after;
+    // neighbouring blocks by virtual address
+    Variable *prev;
+    Variable *next;
 } Variable;
 
 typedef struct Process {
     uint32_t pid;
-    std::vector<Variable *> variables;
+    Variable *first_variable; // lowest addressed block, blocks are linked in address order
+    FreeSpace free_space; // index of the <FREE_SPACE> blocks
+    // index of the variables that are not free, variables point at their key as their name
+    std::unordered_map<std::string, Variable *> variables_by_name;
+    ObjectPool<Variable> blocks; // every block of the process, freed all at once with it
 } Process;
 
+// Processes whose pid falls in one shard, and the lock that guards the slots
+typedef struct ProcessShard {
+    std::mutex lock;
+    // Slot array indexed by (pid - first pid) / shard count, terminated processes leave a NULL slot
+    std::vector<Process *> processes;
+    ObjectPool<Process> process_pool;
+} ProcessShard;
+
 class Mmu {
 private:
-    uint32_t _next_pid;
+    uint32_t _first_pid;
+    std::atomic<uint32_t> _next_pid;
     int _max_size;
-    std::vector<Process *> _processes;
+    AllocationPolicy _policy;
+    // allocation counters for 'print heap'
+    std::atomic<long> _allocations;
+    std::atomic<long> _failed_allocations;
+    std::atomic<long> _allocation_time_ns;
+    int _shard_count;
+    bool _concurrent; // more than one shard, client threads may share the process table
+    ProcessShard *_shards;
+
+    ProcessShard *getShard(uint32_t pid);
+
+    Process *allocateProcess(uint32_t pid);
+
+    Variable *createVariable(Process *process, int address, int size, DataType type);
 
-    Variable *createVariable(std::string name, int address, int size, std::string type);
+    void nameVariable(Process *process, Variable *variable, const std::string &name);
 
-    int calculateVirtualAddress(Process* process, int size);
+    Variable *placeVariable(Process *process, Variable *free_space_var, std::string name, int size, DataType type);
+
+    void alignFreeBlock(Process *process, Variable *free_space_var, int alignment);
+
+    void addProcess(Process *process);
+
+    void deleteProcess(Process *process);
 
 public:
-    Mmu(int memory_size);
+    Mmu(int memory_size, AllocationPolicy policy, int shard_count);
 
     ~Mmu();
 
     uint32_t createProcess();
 
-    int addVariableToProcess(int pid, std::string name, int size, std::string type);
+    int forkProcess(int parent_pid);
+
+    int addVariableToProcess(int pid, std::string name, int size, DataType type);
 
-    std::vector<Variable *> getVariablesFromProcess(int pid);
+    int addPageAlignedVariableToProcess(int pid, std::string name, int size, DataType type, int page_size,
+                                        int page_offset);
+
+    int addAlignedVariableToProcess(int pid, std::string name, int size, DataType type, int alignment);
+
+    void renameVariable(int pid, Variable *variable, const std::string &name);
 
     void print();
 
     void printProcesses();
 
+    void printHeap();
+
     Process *getProcess(int pid);
 
-    Variable *getVariableFromProcess(int pid, std::string name);
+    Variable *getVariableFromProcess(int pid, const std::string &name);
+
+    void freeVariable(int pid, Variable *variable);
 
-    void joinFreeSpace(int pid);
+    Variable *joinFreeSpace(Process *process, Variable *free_space_var);
     
     void terminateProcess(int term_pid);
+
+    void clear();
+
+    void save(CheckpointWriter *writer);
+
+    bool load(CheckpointReader *reader);
 };
 
 #endif // __MMU_H_
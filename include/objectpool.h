@@ -0,0 +1,95 @@
+#ifndef __OBJECTPOOL_H_
+#define __OBJECTPOOL_H_
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Hands out objects of one type from chunks of slots
+ * Released slots go on a free list and are handed out again before a new
+ * slot is used, so objects that live at the same time sit close together.
+ * Chunks start small and double up to a limit, so a pool that only ever
+ * holds a few objects stays small. Destroying the pool frees its chunks
+ * without visiting the objects in them, objects that need their destructor
+ * run have to be released first.
+ */
+template<typename T>
+class ObjectPool {
+private:
+    union Slot {
+        Slot *next; // next free slot while the slot is on the free list
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type object;
+    };
+
+    std::vector<Slot *> _chunks;
+    Slot *_free;
+    int _chunk_size; // slots in the newest chunk
+    int _max_chunk_size;
+    int _chunk_used; // slots of the newest chunk handed out so far
+    long _slots;
+    long _live;
+
+public:
+    explicit ObjectPool(int first_chunk_size = 8, int max_chunk_size = 1024) {
+        _free = NULL;
+        // the first allocation doubles this to first_chunk_size
+        _chunk_size = first_chunk_size / 2;
+        _max_chunk_size = max_chunk_size;
+        _chunk_used = _chunk_size;
+        _slots = 0;
+        _live = 0;
+    }
+
+    ObjectPool(const ObjectPool &) = delete;
+
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    ~ObjectPool() {
+        for (int i = 0; i < _chunks.size(); i++) {
+            std::free(_chunks[i]);
+        }
+    }
+
+    // Returns a value-initialized object
+    T *allocate() {
+        Slot *slot = _free;
+        if (slot != NULL) {
+            _free = slot->next;
+        } else {
+            if (_chunk_used == _chunk_size) {
+                _chunk_size = std::min(_chunk_size * 2, _max_chunk_size);
+                Slot *chunk = (Slot *)std::malloc(sizeof(Slot) * _chunk_size);
+                if (chunk == NULL) {
+                    throw std::bad_alloc();
+                }
+                _chunks.push_back(chunk);
+                _chunk_used = 0;
+                _slots += _chunk_size;
+            }
+            slot = &_chunks.back()[_chunk_used++];
+        }
+        _live++;
+        return new (&slot->object) T();
+    }
+
+    void release(T *object) {
+        object->~T();
+        Slot *slot = (Slot *)object;
+        slot->next = _free;
+        _free = slot;
+        _live--;
+    }
+
+    long getLiveCount() {
+        return _live;
+    }
+
+    long getBytes() {
+        return _slots * sizeof(Slot);
+    }
+};
+
+#endif // __OBJECTPOOL_H_
@@ -0,0 +1,51 @@
+#ifndef __PAGEREPLACER_H_
+#define __PAGEREPLACER_H_
+
+#include <cstdint>
+#include <vector>
+
+enum ReplacementPolicy {
+    REPLACE_FIFO,
+    REPLACE_LRU,
+    REPLACE_CLOCK
+};
+
+/*
+ * Chooses which resident frame to evict when the frame pool is full
+ * FIFO and LRU keep the resident frames in a doubly linked list threaded through
+ * per-frame arrays: FIFO in the order they were loaded, LRU moving a frame to the
+ * back whenever it is used. CLOCK sweeps a hand over the frames and evicts the
+ * first one whose referenced bit is clear, clearing the bits it passes.
+ */
+class PageReplacer {
+private:
+    ReplacementPolicy _policy;
+    std::vector<int> _prev; // -1 at the front of the list
+    std::vector<int> _next; // -1 at the back of the list
+    std::vector<bool> _resident;
+    std::vector<bool> _referenced;
+    int _front;
+    int _back;
+    int _hand;
+
+    void append(int frame);
+
+    void unlink(int frame);
+
+public:
+    PageReplacer(int frame_count, ReplacementPolicy policy);
+
+    ~PageReplacer();
+
+    ReplacementPolicy getPolicy();
+
+    void loaded(int frame);
+
+    void accessed(int frame);
+
+    void released(int frame);
+
+    int selectVictim();
+};
+
+#endif // __PAGEREPLACER_H_
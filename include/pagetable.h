@@ -3,33 +3,151 @@
 
 #include <iostream>
 #include <iomanip>
+#include <atomic>
+#include <mutex>
 #include <string>
-#include <map>
 #include <vector>
+#include <unordered_map>
+#include "frameallocator.h"
+#include "tlb.h"
+#include "physicalmemory.h"
+#include "swapfile.h"
+#include "pagereplacer.h"
+#include "processpagetable.h"
+#include "checkpoint.h"
+
+// Page held by a frame, so a victim frame can be traced back to its entry
+typedef struct FrameOwner {
+    uint32_t pid;
+    int page_number;
+} FrameOwner;
+
+// Tables of the processes whose pid falls in one shard, and the lock that guards them
+typedef struct PageTableShard {
+    std::mutex lock;
+    // Per-process tables indexed by pid / shard count, NULL for processes without one
+    std::vector<ProcessPageTable *> tables;
+    // Large page tables, indexed the same way by pid and then by large page number
+    std::vector<std::vector<PageTableEntry> > large_tables;
+} PageTableShard;
 
 class PageTable {
 private:
     int _page_size;
-    // <"pid|page_number", frame>
-    std::map<std::string, int> _table;
-    std::vector<int> _frames;
+    PageTableLayout _layout;
+    int _page_number_bits; // bits in the largest page number a virtual address can have
+    int _shard_count;
+    bool _concurrent; // more than one shard, client threads may share the table
+    PageTableShard *_shards;
+    FrameAllocator _frame_allocator;
+    std::mutex _frame_lock;
+    // Every simulated core has its own TLB and, in concurrent mode, a cache of free frames
+    std::vector<Tlb *> _tlbs;
+    std::vector<std::vector<int> > _frame_caches;
+    static thread_local int _core;
+    // Swap, only set up when the frame pool is bounded by physical memory
+    PhysicalMemory *_memory;
+    SwapFile *_swap;
+    PageReplacer *_replacer;
+    int _frame_count;
+    std::vector<FrameOwner> _frame_owners;
+    long _faults;
+    long _evictions;
+    int _large_pages; // base pages per large page, 1 without large pages
+    // Frames mapped by more than one entry after a fork or share -> number of entries mapping them
+    // Large pages are counted by their first frame. Shared frames are never evicted, and are copied on
+    // write unless the entry belongs to a shared segment
+    // Fork and share update it under the shard locks of the processes involved only, so it has a lock of
+    // its own. The lock is taken after _frame_lock when both are held
+    std::unordered_map<int, int> _frame_shares;
+    // With swap, the entries mapping each shared frame, so the last one left can own the frame again
+    std::unordered_map<int, std::vector<FrameOwner> > _frame_sharers;
+    std::mutex _share_lock;
+    std::atomic<int> _shared_frames; // size of _frame_shares, read without the lock
+    long _copies;
+
+    PageTableShard *getShard(uint32_t pid);
+
+    ProcessPageTable *getTable(PageTableShard *shard, uint32_t pid);
+
+    std::vector<PageTableEntry> *getLargeTable(PageTableShard *shard, uint32_t pid);
+
+    int allocateFrame();
+
+    void releaseFrame(int frame);
+
+    void uncommitFrames(int first_frame, int count);
+
+    void loadFrame(uint32_t pid, PageTableEntry *entry, int page_number, int frame);
+
+    bool evictFrame();
+
+    void swapIn(uint32_t pid, PageTableEntry *entry, int page_number);
+
+    bool isShared(int frame);
+
+    void shareFrame(int frame, uint32_t pid, int page_number);
+
+    bool unshareFrame(int frame, uint32_t pid, int page_number);
+
+    bool copyOnWrite(uint32_t pid, PageTableEntry *entry, int page_number);
+
+    bool copyOnWriteLarge(uint32_t pid, PageTableEntry *entry, int large_page_number);
+
+    void unmapPage(uint32_t pid, PageTableEntry *entry, int page_number);
 
 public:
-    PageTable(int page_size);
+    PageTable(int page_size, Tlb *tlb, int shard_count, PageTableLayout layout);
 
     ~PageTable();
 
+    int addCore(Tlb *tlb);
+
+    static void setCore(int core);
+
+    void setPhysicalMemory(PhysicalMemory *memory);
+
+    void enableSwap(SwapFile *swap, ReplacementPolicy policy);
+
+    void enableLargePages(int pages);
+
+    int getLargePages();
+
     void addEntry(uint32_t pid, int page_number);
 
     void removeEntry(uint32_t pid, int page_number);
+
+    void addLargeEntry(uint32_t pid, int large_page_number);
+
+    void removeLargeEntry(uint32_t pid, int large_page_number);
     
     void removeProcess(uint32_t pid);
 
-    int getPhysicalAddress(uint32_t pid, int virtual_address);
+    void forkProcess(uint32_t parent_pid, uint32_t child_pid);
+
+    bool sharePages(uint32_t pid, int first_page_number, uint32_t target_pid, int target_first_page_number, int count);
+
+    long getPhysicalAddress(uint32_t pid, int virtual_address, bool write = false);
+
+    int getPageSize();
+
+    long getFaultCount();
+
+    long getEvictionCount();
 
     void print();
 
-    void splitEntry(std::string *entry, std::string *pid, std::string *page_number);
+    void printSwap();
+
+    void printPtes();
+
+    void printMemory();
+
+    void clear();
+
+    bool save(CheckpointWriter *writer, std::string *error);
+
+    bool load(CheckpointReader *reader, std::string *error);
 };
 
 #endif // __PAGETABLE_H_
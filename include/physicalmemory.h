@@ -0,0 +1,52 @@
+#ifndef __PHYSICALMEMORY_H_
+#define __PHYSICALMEMORY_H_
+
+#include <iostream>
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include "checkpoint.h"
+
+/*
+ * Simulated physical memory
+ * The whole size is reserved up front as anonymous memory that the OS only
+ * backs with real pages once they are touched, so a run only pays for the
+ * frames it writes to. Frames that have been written are tracked so
+ * committed and reserved bytes can be reported, and released frames are
+ * handed back to the OS. Commit tracking is atomic so
+ * client threads can write to memory concurrently. A checkpoint's frame
+ * image can be mapped over the memory, its frames are then read in lazily.
+ */
+class PhysicalMemory {
+private:
+    uint8_t *_memory;
+    long _size;
+    int _frame_size;
+    std::vector<uint64_t> _committed; // bit set = frame has been written
+    std::atomic<long> _committed_frames;
+
+public:
+    PhysicalMemory(long size, int frame_size);
+
+    ~PhysicalMemory();
+
+    bool isReserved();
+
+    long getSize();
+
+    uint8_t *access(long physical_address, long length, bool write);
+
+    void release(long first_frame, long count);
+
+    void save(CheckpointWriter *writer);
+
+    bool writeImage(int fd, long offset);
+
+    bool load(CheckpointReader *reader);
+
+    bool mapImage(int fd, long offset);
+
+    void print();
+};
+
+#endif // __PHYSICALMEMORY_H_
@@ -0,0 +1,92 @@
+#ifndef __PROCESSPAGETABLE_H_
+#define __PROCESSPAGETABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef struct PageTableEntry {
+    int frame; // -1 if the page is not in physical memory
+    int references; // number of variables that have bytes on the page
+    int swap_slot; // -1 if the page is not in the swap file
+    bool shared; // mapped by a shared segment, writes go to the shared frame instead of a copy
+} PageTableEntry;
+
+enum PageTableLayout {
+    PAGE_TABLE_FLAT,
+    PAGE_TABLE_TWO_LEVEL,
+    PAGE_TABLE_THREE_LEVEL
+};
+
+/*
+ * One process's page table entries, indexed by page number
+ * The flat layout is a dense array that grows to the highest page used. The
+ * radix layouts split the page number into a directory index per level and a
+ * table index, and only allocate the inner directories and leaf tables that
+ * hold a mapped page, like a hardware page table walk.
+ */
+class ProcessPageTable {
+private:
+    PageTableLayout _layout;
+    std::vector<PageTableEntry> _entries; // flat layout
+    int _levels;
+    int _bits[3]; // page number bits resolved at each level, top level first
+    void **_root; // directories hold pointers to the next level, the last level holds entries
+    long _radix_bytes;
+
+    void **allocateDirectory(int level);
+
+    void freeDirectory(void **directory, int level);
+
+    template<typename F>
+    void forEachInDirectory(void **directory, int level, int first_page, F f);
+
+public:
+    ProcessPageTable(PageTableLayout layout, int page_number_bits);
+
+    ~ProcessPageTable();
+
+    PageTableEntry *getEntry(int page_number, bool create);
+
+    long getMemoryBytes();
+
+    // Calls f(page_number, entry) for every entry in page number order
+    template<typename F>
+    void forEachEntry(F f);
+};
+
+template<typename F>
+void ProcessPageTable::forEachEntry(F f) {
+    if (_layout == PAGE_TABLE_FLAT) {
+        for (int page = 0; page < _entries.size(); page++) {
+            f(page, &_entries[page]);
+        }
+    } else {
+        forEachInDirectory(_root, 0, 0, f);
+    }
+}
+
+template<typename F>
+void ProcessPageTable::forEachInDirectory(void **directory, int level, int first_page, F f) {
+    // pages below this level
+    int shift = 0;
+    for (int i = level + 1; i < _levels; i++) {
+        shift += _bits[i];
+    }
+    for (int i = 0; i < (1 << _bits[level]); i++) {
+        if (directory[i] == NULL) {
+            continue;
+        }
+        int page = first_page + (i << shift);
+        if (level + 2 < _levels) {
+            forEachInDirectory((void **)directory[i], level + 1, page, f);
+        } else {
+            PageTableEntry *table = (PageTableEntry *)directory[i];
+            for (int j = 0; j < (1 << _bits[_levels - 1]); j++) {
+                f(page + j, &table[j]);
+            }
+        }
+    }
+}
+
+#endif // __PROCESSPAGETABLE_H_
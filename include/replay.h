@@ -0,0 +1,30 @@
+#ifndef __REPLAY_H_
+#define __REPLAY_H_
+
+#include <cstdint>
+#include "simulator.h"
+
+/*
+ * Replays a trace of memory accesses straight through the page table and physical memory
+ * A trace is either text, one "<pid> <virtual_address> <r|w>" access per line (addresses
+ * may be written in hex with 0x, lines starting with # are comments), or binary: the
+ * 8 byte magic "MEMTRACE" followed by TraceRecords. The file is mapped rather than read
+ * so traces of any size stream through the page cache. Pages are mapped the first time
+ * a process touches them. The page table is indexed by pid, so accesses by pids above
+ * max_trace_pid are counted as invalid.
+ */
+
+// Binary trace record
+typedef struct TraceRecord {
+    uint32_t pid;
+    uint32_t virtual_address;
+    uint32_t flags; // TRACE_WRITE for a write, reads otherwise
+} TraceRecord;
+
+const uint32_t TRACE_WRITE = 1;
+
+const uint32_t max_trace_pid = 1 << 20;
+
+bool replayTrace(const char *path, Simulator *sim);
+
+#endif // __REPLAY_H_
@@ -0,0 +1,57 @@
+#ifndef __SIMULATOR_H_
+#define __SIMULATOR_H_
+
+#include <string>
+#include "mmu.h"
+#include "pagetable.h"
+#include "tlb.h"
+#include "physicalmemory.h"
+
+// Everything a command needs to run
+typedef struct Simulator {
+    Mmu *mmu;
+    PageTable *pageTable;
+    Tlb *tlb;
+    int page_size;
+    PhysicalMemory *memory;
+} Simulator;
+
+void create(int text_size, int data_size, Mmu *mmu, PageTable *pageTable, int page_size);
+
+void allocate(int pid, std::string var_name, std::string data_type, int number_of_elements, Mmu *mmu,
+              PageTable *pageTable, int page_size);
+
+void set(int pid, std::string var_name, int offset, char **values, int count, Mmu *mmu, PageTable *pageTable, int page_size, PhysicalMemory *memory);
+
+int addVariable(int pid, std::string var_name, int size, DataType type, Mmu *mmu, PageTable *pageTable, int page_size);
+
+void printVariable(int pid, std::string name, Mmu *mmu, PageTable *pageTable, PhysicalMemory *memory);
+
+void fill(int pid, std::string var_name, int offset, int count, const char *value, Mmu *mmu, PageTable *pageTable,
+          PhysicalMemory *memory);
+
+void copy(int source_pid, std::string source_name, int destination_pid, std::string destination_name, int count,
+          Mmu *mmu, PageTable *pageTable, PhysicalMemory *memory);
+
+void compare(int pid_a, std::string name_a, int pid_b, std::string name_b, int count, Mmu *mmu, PageTable *pageTable,
+             PhysicalMemory *memory);
+
+void free(int pid, std::string name, Mmu *mmu, PageTable *pageTable, int page_size);
+
+void getPageRange(int virtual_address, int size, int page_size, int *first_page_number, int *last_page_number);
+
+void getLargePageRange(int virtual_address, int size, int large_page_size, int *first_large_page_number,
+                       int *last_large_page_number);
+
+void mapVariablePages(int pid, int virtual_address, int size, PageTable *pageTable, int page_size);
+
+void unmapVariablePages(int pid, int virtual_address, int size, PageTable *pageTable, int page_size);
+
+void terminate(int pid, Mmu *mmu, PageTable *pageTable, int page_size);
+
+void fork(int pid, Mmu *mmu, PageTable *pageTable);
+
+void share(int pid, std::string var_name, int target_pid, std::string target_name, Mmu *mmu, PageTable *pageTable,
+           int page_size, PhysicalMemory *memory);
+
+#endif // __SIMULATOR_H_
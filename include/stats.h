@@ -0,0 +1,93 @@
+#ifndef __STATS_H_
+#define __STATS_H_
+
+#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * Performance counters
+ * Every instrumented operation keeps a call count and a latency histogram with
+ * one bucket per power of two ticks. Ticks come from the time stamp counter
+ * where there is one and steady_clock otherwise, and are only converted to
+ * nanoseconds when the stats are printed. Every thread records into its own
+ * histograms, which are only summed when the stats are printed, so client
+ * threads never write to the same counters.
+ * Building with -DMEMSIM_NO_STATS (make STATS=0) compiles every STAT_SCOPE out.
+ */
+
+enum StatOperation {
+    // commands
+    STAT_CREATE,
+    STAT_ALLOCATE,
+    STAT_SET,
+    STAT_PRINT,
+    STAT_FREE,
+    STAT_TERMINATE,
+    STAT_FORK,
+    STAT_SHARE,
+    STAT_SAVE,
+    STAT_LOAD,
+    STAT_FILL,
+    STAT_COPY,
+    STAT_COMPARE,
+    // core operations
+    STAT_TRANSLATE,
+    STAT_FRAME_ALLOCATE,
+    STAT_HEAP_ALLOCATE,
+    STAT_VARIABLE_LOOKUP,
+    STAT_COALESCE,
+    STAT_PAGE_FAULT,
+    STAT_EVICTION,
+    STAT_OPERATION_COUNT
+};
+
+const int stat_buckets = 48;
+
+// Only the thread that owns a histogram writes it, the call count is the sum of the buckets
+typedef struct StatHistogram {
+    std::atomic<uint64_t> total_ticks;
+    std::atomic<uint64_t> buckets[stat_buckets]; // bucket b counts latencies under 2^b ticks
+} StatHistogram;
+
+inline uint64_t readStatTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void recordStat(StatOperation operation, uint64_t ticks);
+
+void printStats(std::ostream &out);
+
+// Records the time from its construction to the end of the scope it is in
+class StatTimer {
+private:
+    StatOperation _operation;
+    uint64_t _start;
+
+public:
+    StatTimer(StatOperation operation) {
+        _operation = operation;
+        _start = readStatTicks();
+    }
+
+    ~StatTimer() {
+        recordStat(_operation, readStatTicks() - _start);
+    }
+};
+
+#ifndef MEMSIM_NO_STATS
+#define STAT_SCOPE(operation) StatTimer stat_timer(operation)
+#else
+#define STAT_SCOPE(operation)
+#endif
+
+#endif // __STATS_H_
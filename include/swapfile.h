@@ -0,0 +1,43 @@
+#ifndef __SWAPFILE_H_
+#define __SWAPFILE_H_
+
+#include <iostream>
+#include <cstdint>
+#include <string>
+#include "frameallocator.h"
+
+/*
+ * Backing store for pages evicted from physical memory
+ * The file is split into page sized slots, handed out lowest-free-first like
+ * frames, and pages are moved in and out of it with pwrite and pread.
+ */
+class SwapFile {
+private:
+    int _fd;
+    std::string _path;
+    int _page_size;
+    FrameAllocator _slots;
+    long _page_outs;
+    long _page_ins;
+    long _bytes_written;
+    long _bytes_read;
+
+public:
+    SwapFile(const std::string &path, int page_size);
+
+    ~SwapFile();
+
+    bool isOpen();
+
+    int writePage(const uint8_t *page);
+
+    bool readPage(int slot, uint8_t *page);
+
+    int copyPage(int slot);
+
+    void release(int slot);
+
+    void print();
+};
+
+#endif // __SWAPFILE_H_
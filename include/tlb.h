@@ -0,0 +1,82 @@
+#ifndef __TLB_H_
+#define __TLB_H_
+
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum TlbPolicy {
+    TLB_LRU,
+    TLB_RANDOM
+};
+
+typedef struct TlbEntry {
+    bool valid;
+    uint32_t pid;
+    int page_number; // large page number for large entries
+    bool large;
+    int frame; // first frame for large entries
+    uint64_t last_used; // for LRU replacement
+} TlbEntry;
+
+typedef struct TlbStats {
+    uint64_t hits;
+    uint64_t misses;
+} TlbStats;
+
+/*
+ * Set-associative translation lookaside buffer caching (pid, page number) -> frame
+ * With large pages, an entry can also map a whole large page, so a base page that
+ * misses is looked up again by the large page it is in
+ */
+class Tlb {
+private:
+    int _sets;
+    int _ways;
+    TlbPolicy _policy;
+    std::vector<TlbEntry> _entries; // _sets rows of _ways entries
+    std::vector<TlbStats> _stats; // indexed by pid
+    int _large_pages; // base pages per large page, 1 without large pages
+    uint64_t _clock;
+    uint32_t _random_state;
+    // other cores invalidate entries in this TLB, so it is locked in concurrent mode
+    std::mutex _lock;
+    bool _concurrent;
+
+    int getSet(uint32_t pid, int page_number);
+
+    TlbStats *getStats(uint32_t pid);
+
+    TlbEntry *find(uint32_t pid, int page_number, bool large);
+
+    void fill(uint32_t pid, int page_number, bool large, int frame);
+
+public:
+    Tlb(int sets, int ways, TlbPolicy policy);
+
+    ~Tlb();
+
+    void setConcurrent(bool concurrent);
+
+    void setLargePages(int pages);
+
+    bool lookup(uint32_t pid, int page_number, int *frame);
+
+    void insert(uint32_t pid, int page_number, int frame);
+
+    void insertLarge(uint32_t pid, int large_page_number, int first_frame);
+
+    void invalidate(uint32_t pid, int page_number);
+
+    void invalidateLarge(uint32_t pid, int large_page_number);
+
+    void invalidateProcess(uint32_t pid);
+
+    void flush();
+
+    void print(int page_size);
+};
+
+#endif // __TLB_H_
@@ -0,0 +1,40 @@
+#ifndef __VIRTUALCOPY_H_
+#define __VIRTUALCOPY_H_
+
+#include <cstdint>
+#include "pagetable.h"
+#include "physicalmemory.h"
+
+/*
+ * Copies between a buffer and a range of a process's virtual memory
+ * The range is split at page boundaries and each page is translated once,
+ * so ranges that span pages mapped to frames that are not next to each
+ * other are copied correctly. Returns false if a page in the range is not
+ * mapped or a frame is outside of physical memory. Copies to virtual memory
+ * translate for writing, so shared frames are copied first.
+ */
+bool copyToVirtual(PageTable *pageTable, PhysicalMemory *memory, uint32_t pid, int virtual_address,
+                   const void *source, long length);
+
+bool copyFromVirtual(PageTable *pageTable, PhysicalMemory *memory, uint32_t pid, int virtual_address,
+                     void *destination, long length);
+
+/*
+ * Bulk operations that work on the frames in place, a page at a time, with
+ * memset, memcpy and memcmp. Copies and compares between two ranges split
+ * at the page boundaries of both, so each step stays inside one frame of
+ * each range.
+ */
+
+// Writes count copies of a pattern of pattern_size bytes
+bool fillVirtual(PageTable *pageTable, PhysicalMemory *memory, uint32_t pid, int virtual_address,
+                 const void *pattern, int pattern_size, long count);
+
+bool copyVirtual(PageTable *pageTable, PhysicalMemory *memory, uint32_t source_pid, int source_address,
+                 uint32_t destination_pid, int destination_address, long length);
+
+// Sets difference to the offset of the first byte that differs, or -1 if the ranges are equal
+bool compareVirtual(PageTable *pageTable, PhysicalMemory *memory, uint32_t pid_a, int address_a, uint32_t pid_b,
+                    int address_b, long length, long *difference);
+
+#endif // __VIRTUALCOPY_H_
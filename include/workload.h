@@ -0,0 +1,16 @@
+#ifndef __WORKLOAD_H_
+#define __WORKLOAD_H_
+
+#include "simulator.h"
+
+/*
+ * Concurrent allocation workload
+ * Each client thread simulates one core: it drives its own processes with a
+ * random mix of allocations, writes, reads and frees, and now and then
+ * terminates a process and creates a new one. Threads only share the process
+ * table, the page table and physical memory, so throughput shows how well
+ * they scale with cores.
+ */
+void runConcurrentWorkload(Simulator *sim, const std::vector<int> &cores, long operations);
+
+#endif // __WORKLOAD_H_
@@ -0,0 +1,172 @@
+#include "checkpoint.h"
+#include "simulator.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char checkpoint_magic[8] = {'M', 'E', 'M', 'S', 'I', 'M', 'C', 'P'};
+const uint32_t checkpoint_version = 2;
+
+CheckpointWriter::CheckpointWriter(FILE *file) {
+    _file = file;
+    _ok = true;
+}
+
+void CheckpointWriter::writeBytes(const void *data, long length) {
+    if (_ok && length > 0 && fwrite(data, 1, length, _file) != (size_t)length) {
+        _ok = false;
+    }
+}
+
+void CheckpointWriter::writeString(const std::string &value) {
+    write<uint32_t>(value.size());
+    writeBytes(value.data(), value.size());
+}
+
+bool CheckpointWriter::isOk() {
+    return _ok;
+}
+
+CheckpointReader::CheckpointReader(const uint8_t *data, long size) {
+    _data = data;
+    _size = size;
+    _position = 0;
+    _ok = true;
+}
+
+bool CheckpointReader::readBytes(void *data, long length) {
+    if (!_ok || length < 0 || length > _size - _position) {
+        _ok = false;
+        return false;
+    }
+    memcpy(data, _data + _position, length);
+    _position += length;
+    return true;
+}
+
+bool CheckpointReader::readString(std::string *value) {
+    uint32_t length;
+    if (!read(&length) || length > _size - _position) {
+        _ok = false;
+        return false;
+    }
+    value->assign((const char *)_data + _position, length);
+    _position += length;
+    return true;
+}
+
+/*
+ * Writes the simulator's state and frames to a checkpoint file
+ * The file is written next to path and renamed over it at the end, so a
+ * checkpoint that is mapped into physical memory right now is never truncated
+ */
+bool saveCheckpoint(const char *path, Simulator *sim, std::string *error) {
+    std::string temporary_path = std::string(path) + ".tmp";
+    FILE *file = fopen(temporary_path.c_str(), "wb");
+    if (file == NULL) {
+        *error = "could not open " + temporary_path;
+        return false;
+    }
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+    header.version = checkpoint_version;
+    header.page_size = sim->page_size;
+    header.memory_size = sim->memory->getSize();
+    header.large_pages = sim->pageTable->getLargePages();
+
+    CheckpointWriter writer(file);
+    writer.write(header); // filled in once the state size is known
+    sim->mmu->save(&writer);
+    bool saved = sim->pageTable->save(&writer, error);
+    if (saved) {
+        sim->memory->save(&writer);
+        // the image is mapped straight over physical memory, so it has to start on a page of the host
+        long alignment = std::max(sysconf(_SC_PAGESIZE), (long)sim->page_size);
+        long state_end = ftell(file);
+        header.state_size = state_end - sizeof(header);
+        header.image_offset = (state_end + alignment - 1) / alignment * alignment;
+        saved = writer.isOk() && fflush(file) == 0 &&
+                ftruncate(fileno(file), header.image_offset + header.memory_size) == 0 &&
+                sim->memory->writeImage(fileno(file), header.image_offset) &&
+                pwrite(fileno(file), &header, sizeof(header), 0) == sizeof(header);
+        if (!saved) {
+            *error = "could not write " + temporary_path;
+        }
+    }
+    if (fclose(file) != 0 && saved) {
+        *error = "could not write " + temporary_path;
+        saved = false;
+    }
+    if (saved && rename(temporary_path.c_str(), path) != 0) {
+        *error = "could not replace " + std::string(path);
+        saved = false;
+    }
+    if (!saved) {
+        unlink(temporary_path.c_str());
+    }
+    return saved;
+}
+
+/*
+ * Replaces the simulator's state with a checkpoint
+ * The page size, memory size and large pages have to be the ones the checkpoint was taken with.
+ * If the state in the file is cut short the simulator is left with no processes.
+ */
+bool loadCheckpoint(const char *path, Simulator *sim, std::string *error) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        *error = "could not open " + std::string(path);
+        return false;
+    }
+    struct stat file_stat;
+    void *mapped = MAP_FAILED;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size >= (off_t)sizeof(CheckpointHeader)) {
+        mapped = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (mapped == MAP_FAILED) {
+        close(fd);
+        *error = std::string(path) + " is not a checkpoint";
+        return false;
+    }
+
+    const uint8_t *data = (const uint8_t *)mapped;
+    CheckpointHeader header;
+    memcpy(&header, data, sizeof(header));
+    bool loaded = false;
+    if (memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) != 0 || header.version != checkpoint_version) {
+        *error = std::string(path) + " is not a checkpoint";
+    } else if (header.page_size != sim->page_size) {
+        *error = "it was taken with a page size of " + std::to_string(header.page_size);
+    } else if (header.memory_size != sim->memory->getSize()) {
+        *error = "it was taken with " + std::to_string(header.memory_size) + " bytes of memory";
+    } else if (header.large_pages != sim->pageTable->getLargePages()) {
+        *error = header.large_pages > 1 ? "it was taken with large pages of " +
+                                          std::to_string(header.large_pages) + " pages"
+                                        : "it was taken without large pages";
+    } else if (header.state_size < 0 || header.image_offset < (long)sizeof(header) + header.state_size ||
+               file_stat.st_size < header.image_offset + header.memory_size) {
+        *error = std::string(path) + " is cut short";
+    } else {
+        CheckpointReader reader(data + sizeof(header), header.state_size);
+        loaded = sim->mmu->load(&reader) && sim->pageTable->load(&reader, error) && sim->memory->load(&reader);
+        if (loaded && !sim->memory->mapImage(fd, header.image_offset)) {
+            *error = "could not map the frames of " + std::string(path);
+            loaded = false;
+        } else if (!loaded && error->empty()) {
+            *error = std::string(path) + " is cut short";
+        }
+        if (!loaded) {
+            sim->mmu->clear();
+            sim->pageTable->clear();
+        }
+    }
+    munmap(mapped, file_stat.st_size);
+    // the frame image stays mapped after the file is closed
+    close(fd);
+    return loaded;
+}
@@ -0,0 +1,129 @@
+#include "command.h"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
+/*
+ * Splits a line at spaces into a command name and its arguments
+ * Repeated spaces are skipped, the arguments vector keeps its capacity between calls
+ */
+void tokenizeCommand(char *line, CommandLine *command) {
+    command->name = NULL;
+    command->arguments.clear();
+
+    char *position = line;
+    while (*position != '\0') {
+        // skip spaces (and a carriage return left from a windows line ending)
+        while (*position == ' ' || *position == '\t' || *position == '\r') {
+            *position = '\0';
+            position++;
+        }
+        if (*position == '\0') {
+            break;
+        }
+        if (command->name == NULL) {
+            command->name = position;
+        } else {
+            command->arguments.push_back(position);
+        }
+        while (*position != '\0' && *position != ' ' && *position != '\t' && *position != '\r') {
+            position++;
+        }
+    }
+
+    if (command->name == NULL) {
+        command->name = position;
+    }
+}
+
+/*
+ * Splits a token at the first delimiter in place
+ * Returns the part after the delimiter, or NULL if the delimiter is not found
+ */
+char *splitToken(char *token, char delimiter) {
+    for (char *position = token; *position != '\0'; position++) {
+        if (*position == delimiter) {
+            *position = '\0';
+            return position + 1;
+        }
+    }
+    return NULL;
+}
+
+// Rebuilds the command line text, used for error messages
+std::string joinCommand(CommandLine *command) {
+    std::string text = command->name;
+    for (int i = 0; i < command->arguments.size(); i++) {
+        text += " ";
+        text += command->arguments[i];
+    }
+    return text;
+}
+
+bool parseLong(const char *text, long *value) {
+    char *end;
+    errno = 0;
+    long result = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE) {
+        return false;
+    }
+    *value = result;
+    return true;
+}
+
+bool parseInt(const char *text, int *value) {
+    long result;
+    if (!parseLong(text, &result) || result < INT_MIN || result > INT_MAX) {
+        return false;
+    }
+    *value = (int)result;
+    return true;
+}
+
+/*
+ * Parses a byte count with an optional K, M or G suffix (64M = 67108864)
+ */
+bool parseSize(const char *text, long *value) {
+    char *end;
+    errno = 0;
+    long result = strtol(text, &end, 10);
+    if (end == text || result < 0 || errno == ERANGE) {
+        return false;
+    }
+    int shift = 0;
+    if (*end == 'K' || *end == 'k') {
+        shift = 10;
+    } else if (*end == 'M' || *end == 'm') {
+        shift = 20;
+    } else if (*end == 'G' || *end == 'g') {
+        shift = 30;
+    }
+    if (shift != 0) {
+        end++;
+    }
+    if (*end != '\0' || result > (LONG_MAX >> shift)) {
+        return false;
+    }
+    *value = result << shift;
+    return true;
+}
+
+bool parseDouble(const char *text, double *value) {
+    char *end;
+    double result = strtod(text, &end);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    *value = result;
+    return true;
+}
+
+bool parseFloat(const char *text, float *value) {
+    char *end;
+    float result = strtof(text, &end);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    *value = result;
+    return true;
+}
@@ -0,0 +1,31 @@
+#include "datatype.h"
+
+const char *data_type_names[DATA_TYPE_COUNT] = {
+        "",
+        "char",
+        "short",
+        "int",
+        "float",
+        "long",
+        "double"
+};
+
+const int data_type_sizes[DATA_TYPE_COUNT] = {
+        0,
+        sizeof(DataTypeTraits<TYPE_CHAR>::value_type),
+        sizeof(DataTypeTraits<TYPE_SHORT>::value_type),
+        sizeof(DataTypeTraits<TYPE_INT>::value_type),
+        sizeof(DataTypeTraits<TYPE_FLOAT>::value_type),
+        sizeof(DataTypeTraits<TYPE_LONG>::value_type),
+        sizeof(DataTypeTraits<TYPE_DOUBLE>::value_type)
+};
+
+// Returns the type with the given name, or TYPE_NONE if there is no such type
+DataType parseDataType(const std::string &name) {
+    for (int type = TYPE_NONE + 1; type < DATA_TYPE_COUNT; type++) {
+        if (name == data_type_names[type]) {
+            return (DataType)type;
+        }
+    }
+    return TYPE_NONE;
+}
@@ -0,0 +1,156 @@
+#include "frameallocator.h"
+
+FrameAllocator::FrameAllocator() {
+    _used = 0;
+}
+
+FrameAllocator::~FrameAllocator() {
+}
+
+int FrameAllocator::allocate() {
+    // Find the first bitmap word that is not full
+    int word = _words.size();
+    for (int i = 0; i < _full.size(); i++) {
+        if (_full[i] != ~0ULL) {
+            word = i * 64 + __builtin_ctzll(~_full[i]);
+            break;
+        }
+    }
+    // Every word is full, start a new one at the end
+    if (word >= _words.size()) {
+        word = _words.size();
+        _words.push_back(0);
+        if (word / 64 >= _full.size()) {
+            _full.push_back(0);
+        }
+    }
+
+    int bit = __builtin_ctzll(~_words[word]);
+    _words[word] |= 1ULL << bit;
+    if (_words[word] == ~0ULL) {
+        _full[word / 64] |= 1ULL << (word % 64);
+    }
+    _used++;
+
+    return word * 64 + bit;
+}
+
+// Sets a frame's bit, growing the bitmaps to reach it
+void FrameAllocator::markAllocated(int frame) {
+    int word = frame / 64;
+    while (word >= _words.size()) {
+        _words.push_back(0);
+        if ((_words.size() - 1) / 64 >= _full.size()) {
+            _full.push_back(0);
+        }
+    }
+    _words[word] |= 1ULL << (frame % 64);
+    if (_words[word] == ~0ULL) {
+        _full[word / 64] |= 1ULL << (word % 64);
+    }
+    _used++;
+}
+
+/*
+ * Takes the lowest run of count free frames that starts at a multiple of count
+ * count is a power of two, returns the first frame of the run
+ */
+int FrameAllocator::allocateAligned(int count) {
+    int first = -1;
+    if (count < 64) {
+        // runs sit inside one bitmap word
+        uint64_t mask = (1ULL << count) - 1;
+        for (int word = 0; word < _words.size() && first == -1; word++) {
+            if (_words[word] == ~0ULL) {
+                continue;
+            }
+            for (int bit = 0; bit < 64; bit += count) {
+                if (((_words[word] >> bit) & mask) == 0) {
+                    first = word * 64 + bit;
+                    break;
+                }
+            }
+        }
+    } else {
+        // runs are whole empty bitmap words
+        int words = count / 64;
+        for (int word = 0; word + words <= _words.size() && first == -1; word += words) {
+            bool empty = true;
+            for (int i = 0; i < words && empty; i++) {
+                empty = _words[word + i] == 0;
+            }
+            if (empty) {
+                first = word * 64;
+            }
+        }
+    }
+    // No free run, start one past the end
+    if (first == -1) {
+        first = ((long)_words.size() * 64 + count - 1) / count * count;
+    }
+    for (int frame = first; frame < first + count; frame++) {
+        markAllocated(frame);
+    }
+    return first;
+}
+
+void FrameAllocator::releaseRange(int first_frame, int count) {
+    for (int frame = first_frame; frame < first_frame + count; frame++) {
+        release(frame);
+    }
+}
+
+void FrameAllocator::release(int frame) {
+    if (!isAllocated(frame)) {
+        return;
+    }
+    int word = frame / 64;
+    _words[word] &= ~(1ULL << (frame % 64));
+    _full[word / 64] &= ~(1ULL << (word % 64));
+    _used--;
+}
+
+bool FrameAllocator::isAllocated(int frame) {
+    if (frame < 0 || frame / 64 >= _words.size()) {
+        return false;
+    }
+    return (_words[frame / 64] >> (frame % 64)) & 1;
+}
+
+int FrameAllocator::getUsedCount() {
+    return _used;
+}
+
+// Releases every frame
+void FrameAllocator::clear() {
+    _words.clear();
+    _full.clear();
+    _used = 0;
+}
+
+void FrameAllocator::save(CheckpointWriter *writer) {
+    writer->write<uint32_t>(_words.size());
+    writer->writeBytes(_words.data(), _words.size() * sizeof(uint64_t));
+}
+
+// Restores the bitmap, the summary bitmap and the count are worked out from it
+bool FrameAllocator::load(CheckpointReader *reader) {
+    clear();
+    uint32_t words;
+    if (!reader->read(&words)) {
+        return false;
+    }
+    _words.resize(words);
+    if (!reader->readBytes(_words.data(), words * sizeof(uint64_t))) {
+        clear();
+        return false;
+    }
+    _full.resize((words + 63) / 64, 0);
+    for (uint32_t word = 0; word < words; word++) {
+        if (_words[word] == ~0ULL) {
+            _full[word / 64] |= 1ULL << (word % 64);
+        }
+        _used += __builtin_popcountll(_words[word]);
+    }
+    return true;
+}
@@ -0,0 +1,163 @@
+#include "freespace.h"
+#include "mmu.h"
+#include <algorithm>
+#include <climits>
+
+FreeSpace::FreeSpace() {
+    _root = NULL;
+    _block_count = 0;
+    _free_bytes = 0;
+    _next_fit_address = 0;
+}
+
+// The nodes are freed with their pool
+FreeSpace::~FreeSpace() {
+}
+
+void FreeSpace::update(FreeSpaceNode *node) {
+    node->max_size = node->size;
+    if (node->left != NULL) {
+        node->max_size = std::max(node->max_size, node->left->max_size);
+    }
+    if (node->right != NULL) {
+        node->max_size = std::max(node->max_size, node->right->max_size);
+    }
+}
+
+// Splits a subtree into the nodes below the address and the nodes at or above it
+void FreeSpace::split(FreeSpaceNode *node, int address, FreeSpaceNode **before, FreeSpaceNode **after) {
+    if (node == NULL) {
+        *before = NULL;
+        *after = NULL;
+    } else if (node->address < address) {
+        split(node->right, address, &node->right, after);
+        update(node);
+        *before = node;
+    } else {
+        split(node->left, address, before, &node->left);
+        update(node);
+        *after = node;
+    }
+}
+
+// Joins two subtrees, every address in before has to be below every address in after
+FreeSpaceNode *FreeSpace::merge(FreeSpaceNode *before, FreeSpaceNode *after) {
+    if (before == NULL) {
+        return after;
+    }
+    if (after == NULL) {
+        return before;
+    }
+    if (before->priority > after->priority) {
+        before->right = merge(before->right, after);
+        update(before);
+        return before;
+    }
+    after->left = merge(before, after->left);
+    update(after);
+    return after;
+}
+
+/*
+ * Returns the lowest addressed node at or after the address with a block of at least size bytes
+ * Subtrees whose largest block is too small are skipped without going into them
+ */
+FreeSpaceNode *FreeSpace::findFirst(FreeSpaceNode *node, int address, int size) {
+    if (node == NULL || node->max_size < size) {
+        return NULL;
+    }
+    if (node->address < address) {
+        return findFirst(node->right, address, size);
+    }
+    FreeSpaceNode *found = findFirst(node->left, address, size);
+    if (found != NULL) {
+        return found;
+    }
+    if (node->size >= size) {
+        return node;
+    }
+    return findFirst(node->right, address, size);
+}
+
+void FreeSpace::insert(Variable *block) {
+    FreeSpaceNode *node = _nodes.allocate();
+    node->block = block;
+    node->address = block->virtual_address;
+    node->size = block->size;
+    node->max_size = block->size;
+    // priorities come from the address so the same heap always gives the same tree
+    uint32_t hash = (uint32_t)block->virtual_address * 2654435761u;
+    node->priority = hash ^ (hash >> 16);
+
+    FreeSpaceNode *before;
+    FreeSpaceNode *after;
+    split(_root, node->address, &before, &after);
+    _root = merge(merge(before, node), after);
+    _by_size[std::make_pair(block->size, block->virtual_address)] = block;
+    _block_count++;
+    _free_bytes += block->size;
+}
+
+void FreeSpace::remove(Variable *block) {
+    FreeSpaceNode *before;
+    FreeSpaceNode *node;
+    FreeSpaceNode *after;
+    split(_root, block->virtual_address, &before, &after);
+    split(after, block->virtual_address + 1, &node, &after);
+    _root = merge(before, after);
+    if (node != NULL) {
+        _nodes.release(node);
+    }
+    _by_size.erase(std::make_pair(block->size, block->virtual_address));
+    _block_count--;
+    _free_bytes -= block->size;
+}
+
+/*
+ * Returns the free block a variable of the given size should be carved from, or NULL if none fit
+ */
+Variable *FreeSpace::find(int size, AllocationPolicy policy) {
+    if (_root == NULL || _root->max_size < size) {
+        return NULL;
+    }
+
+    if (policy == BEST_FIT) {
+        // smallest block that is big enough, lowest address on a tie
+        return _by_size.lower_bound(std::make_pair(size, INT_MIN))->second;
+    } else if (policy == WORST_FIT) {
+        // largest block, lowest address on a tie
+        return _by_size.lower_bound(std::make_pair(_root->max_size, INT_MIN))->second;
+    } else if (policy == NEXT_FIT) {
+        // pick up where the last allocation left off, then wrap around to the start
+        FreeSpaceNode *node = findFirst(_root, _next_fit_address, size);
+        if (node == NULL) {
+            node = findFirst(_root, INT_MIN, size);
+        }
+        _next_fit_address = node->address + size;
+        return node->block;
+    }
+
+    // first fit, the largest block is known to fit so the descent always finds one
+    return findFirst(_root, INT_MIN, size)->block;
+}
+
+int FreeSpace::getBlockCount() {
+    return _block_count;
+}
+
+long FreeSpace::getFreeBytes() {
+    return _free_bytes;
+}
+
+int FreeSpace::getLargestBlock() {
+    return _root == NULL ? 0 : _root->max_size;
+}
+
+// Where the next next-fit search starts, saved with checkpoints
+int FreeSpace::getNextFitAddress() {
+    return _next_fit_address;
+}
+
+void FreeSpace::setNextFitAddress(int address) {
+    _next_fit_address = address;
+}
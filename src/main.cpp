@@ -2,35 +2,80 @@
 #include <string>
 #include "mmu.h"
 #include "pagetable.h"
+#include "tlb.h"
+#include "command.h"
+#include "physicalmemory.h"
+#include "simulator.h"
+#include "workload.h"
+#include "replay.h"
+#include "stats.h"
+#include "checkpoint.h"
+#include <fstream>
 #include <cmath>
 #include <cstring>
+#include <map>
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+
+typedef struct CommandEntry {
+    const char *name;
+    void (*handler)(CommandLine *command, Simulator *sim);
+    StatOperation operation; // counter the command is timed in
+} CommandEntry;
 
 void printStartMessage(int page_size);
 
-void splitCommand(std::string *first, std::string *second);
+bool runCommand(char *line, Simulator *sim);
+
+long runScript(FILE *script, Simulator *sim);
+
+bool isBlank(const char *line);
+
+void printInvalidCommand(CommandLine *command, const char *reason);
+
+void createCommand(CommandLine *command, Simulator *sim);
+
+void allocateCommand(CommandLine *command, Simulator *sim);
+
+void setCommand(CommandLine *command, Simulator *sim);
+
+void printCommand(CommandLine *command, Simulator *sim);
 
-std::vector <std::string> splitByDelimiter(std::string data, std::string token);
+void freeCommand(CommandLine *command, Simulator *sim);
 
-void create(int text_size, int data_size, Mmu *mmu, PageTable *pageTable, int page_size);
+void terminateCommand(CommandLine *command, Simulator *sim);
 
-void allocate(int pid, std::string var_name, std::string data_type, int number_of_elements, Mmu *mmu,
-              PageTable *pageTable, int page_size);
+void forkCommand(CommandLine *command, Simulator *sim);
 
-void set(int pid, std::string var_name, int offset, std::vector <std::string> values, Mmu *mmu, PageTable *pageTable, int page_size, uint8_t *memory);
+void shareCommand(CommandLine *command, Simulator *sim);
 
-int addVariable(int pid, std::string var_name, int size, std::string type, Mmu *mmu, PageTable *pageTable, int page_size);
+void saveCommand(CommandLine *command, Simulator *sim);
 
-void printVariable(int pid, std::string name, Mmu *mmu, PageTable *pageTable, uint8_t *memory);
+void loadCommand(CommandLine *command, Simulator *sim);
 
-template<typename T>
-void print_physical_data(int physical_address, int size, int type_size, std::vector<T> values, uint8_t *memory);
+void fillCommand(CommandLine *command, Simulator *sim);
 
-void free(int pid, std::string name, Mmu *mmu, PageTable *pageTable, int page_size);
+void copyCommand(CommandLine *command, Simulator *sim);
 
-template<typename T>
-void set_physical_data(int physical_address, int offset, std::vector<std::string> values, std::vector<T> new_values, std::string type, int bytes, uint8_t *memory);
+void compareCommand(CommandLine *command, Simulator *sim);
 
-void terminate(int pid, Mmu *mmu, PageTable *pageTable, int page_size);
+// Command name -> handler
+const CommandEntry commands[] = {
+        {"create", createCommand, STAT_CREATE},
+        {"allocate", allocateCommand, STAT_ALLOCATE},
+        {"set", setCommand, STAT_SET},
+        {"print", printCommand, STAT_PRINT},
+        {"free", freeCommand, STAT_FREE},
+        {"terminate", terminateCommand, STAT_TERMINATE},
+        {"fork", forkCommand, STAT_FORK},
+        {"share", shareCommand, STAT_SHARE},
+        {"save", saveCommand, STAT_SAVE},
+        {"load", loadCommand, STAT_LOAD},
+        {"fill", fillCommand, STAT_FILL},
+        {"copy", copyCommand, STAT_COPY},
+        {"cmp", compareCommand, STAT_COMPARE}
+};
 
 /*
 You will not actually be spawning processes that consume memory.
@@ -55,440 +100,562 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    // Print opening instruction message
-    printStartMessage(page_size);
+    // Optional TLB geometry and replacement policy, heap allocation policy, physical memory size,
+    // a script to run in batch mode, and a number of client threads to run the concurrent workload on
+    // ./memsim 1024 --tlb-sets 16 --tlb-ways 4 --tlb-policy lru --fit first --memory 64M --script trace.txt
+    // ./memsim 1024 --threads 8 --operations 1000000
+    // A swap file lets processes use more memory than there is, evicting pages with the replacement policy
+    // ./memsim 1024 --memory 1M --swap memsim.swap --replacement clock
+    // A trace of memory accesses can be replayed instead of running commands
+    // ./memsim 1024 --replay accesses.trace
+    // Performance counters can be written to a file, or stdout with -, at exit
+    // ./memsim 1024 --stats memsim.stats
+    // Large pages of N base pages are used for the parts of big variables they fit in
+    // ./memsim 4096 --large-pages 16
+    // The page table can be flat, or a two or three level radix tree
+    // ./memsim 4096 --page-table two-level
+    // A checkpoint written with the save command can be loaded before any commands are run
+    // ./memsim 4096 --restore warm.checkpoint
+    int tlb_sets = 16;
+    int tlb_ways = 4;
+    TlbPolicy tlb_policy = TLB_LRU;
+    AllocationPolicy allocation_policy = FIRST_FIT;
+    long memory_size = 67108864; // 64 MB (64 * 1024 * 1024)
+    FILE *script = NULL;
+    int threads = 0;
+    long operations = 1000000;
+    std::string swap_path;
+    std::string replay_path;
+    std::string stats_path;
+    std::string restore_path;
+    int large_pages = 1;
+    PageTableLayout page_table_layout = PAGE_TABLE_FLAT;
+    ReplacementPolicy replacement_policy = REPLACE_CLOCK;
+    for (int i = 2; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Error: %s needs a value\n", argv[i]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (option == "--tlb-sets") {
+            tlb_sets = std::stoi(value);
+        } else if (option == "--tlb-ways") {
+            tlb_ways = std::stoi(value);
+        } else if (option == "--tlb-policy" && (value == "lru" || value == "random")) {
+            tlb_policy = value == "lru" ? TLB_LRU : TLB_RANDOM;
+        } else if (option == "--fit" && value == "first") {
+            allocation_policy = FIRST_FIT;
+        } else if (option == "--fit" && value == "next") {
+            allocation_policy = NEXT_FIT;
+        } else if (option == "--fit" && value == "best") {
+            allocation_policy = BEST_FIT;
+        } else if (option == "--fit" && value == "worst") {
+            allocation_policy = WORST_FIT;
+        } else if (option == "--memory" && parseSize(value.c_str(), &memory_size)) {
+            // whole frames only
+            memory_size -= memory_size % page_size;
+        } else if (option == "--threads" && parseInt(value.c_str(), &threads) && threads > 0) {
+            // one client thread per simulated core
+        } else if (option == "--operations" && parseLong(value.c_str(), &operations) && operations > 0) {
+            // operations run by each client thread
+        } else if (option == "--swap") {
+            swap_path = value;
+        } else if (option == "--replacement" && value == "fifo") {
+            replacement_policy = REPLACE_FIFO;
+        } else if (option == "--replacement" && value == "lru") {
+            replacement_policy = REPLACE_LRU;
+        } else if (option == "--replacement" && value == "clock") {
+            replacement_policy = REPLACE_CLOCK;
+        } else if (option == "--large-pages" && parseInt(value.c_str(), &large_pages) && large_pages > 1 &&
+                   (large_pages & (large_pages - 1)) == 0) {
+            // base pages per large page, a power of two
+        } else if (option == "--page-table" && value == "flat") {
+            page_table_layout = PAGE_TABLE_FLAT;
+        } else if (option == "--page-table" && value == "two-level") {
+            page_table_layout = PAGE_TABLE_TWO_LEVEL;
+        } else if (option == "--page-table" && value == "three-level") {
+            page_table_layout = PAGE_TABLE_THREE_LEVEL;
+        } else if (option == "--stats") {
+            stats_path = value;
+        } else if (option == "--restore") {
+            restore_path = value;
+        } else if (option == "--replay") {
+            replay_path = value;
+        } else if (option == "--script") {
+            script = fopen(value.c_str(), "r");
+            if (script == NULL) {
+                fprintf(stderr, "Error: could not open script %s\n", value.c_str());
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Error: unknown option %s %s\n", option.c_str(), value.c_str());
+            return 1;
+        }
+    }
+    if (memory_size < page_size) {
+        fprintf(stderr, "Error: physical memory must hold at least one page\n");
+        return 1;
+    }
+    if (tlb_sets < 1 || tlb_ways < 1) {
+        fprintf(stderr, "Error: TLB sets and ways must be at least 1\n");
+        return 1;
+    }
+    if (!replay_path.empty() && (threads > 0 || script != NULL)) {
+        fprintf(stderr, "Error: --replay can not be used with --threads or --script\n");
+        return 1;
+    }
+    if (!swap_path.empty() && large_pages > 1) {
+        fprintf(stderr, "Error: --swap can not be used with --large-pages\n");
+        return 1;
+    }
+    if (!swap_path.empty() && threads > 0) {
+        fprintf(stderr, "Error: --swap can not be used with --threads\n");
+        return 1;
+    }
+    if (!restore_path.empty() && (threads > 0 || !replay_path.empty() || !swap_path.empty())) {
+        fprintf(stderr, "Error: --restore can not be used with --threads, --replay or --swap\n");
+        return 1;
+    }
+
+    // Commands piped in on stdin are run as a script too
+    if (script == NULL && threads == 0 && replay_path.empty() && !isatty(STDIN_FILENO)) {
+        script = stdin;
+    }
+
+    if (script != NULL || threads > 0 || !replay_path.empty()) {
+        // Once cout is no longer synced with stdio it has a buffer of its own, so output is
+        // block-buffered instead of going to stdio a character at a time
+        std::ios::sync_with_stdio(false);
+    } else {
+        // Print opening instruction message
+        printStartMessage(page_size);
+    }
 
-    // Create physical 'memory' 64 MB of memory
-    // Array of unsigned ints (8-bit ints, bytes)
-    uint8_t *memory = new uint8_t[67108864]; // 64 MB (64 * 1024 * 1024)
+    // Create physical 'memory', 64 MB unless given with --memory
+    // Only reserved here, frames are committed as they are written
+    PhysicalMemory *memory = new PhysicalMemory(memory_size, page_size);
+    if (!memory->isReserved()) {
+        fprintf(stderr, "Error: could not reserve %ld bytes of physical memory\n", memory_size);
+        return 1;
+    }
+
+    // Client threads share the process table and page table, which are split into shards
+    // by pid so threads working on different processes rarely wait for each other
+    int shard_count = threads > 0 ? 64 : 1;
 
     // Create MMU
-    // MMU memory size is 67108864 bytes (how much memory we have)
-    Mmu *mmu = new Mmu(67108864);
+    // Every process gets a 64 MB virtual address space whatever the size of physical memory,
+    // so with swap a process can use more memory than there are frames
+    Mmu *mmu = new Mmu(67108864, allocation_policy, shard_count);
+
+    // Create TLB that sits in front of the page table
+    Tlb *tlb = new Tlb(tlb_sets, tlb_ways, tlb_policy);
 
     // Create page table using supplied page_size
-    PageTable *pageTable = new PageTable(page_size);
-
-    // Prompt loop
-    // Your simulator should continually ask the user to input a command.
-    std::string command; // create, allocate, set, free, terminate, print
-    std::cout << "> ";
-    std::getline(std::cin, command); // get line typed and store as command
-
-    // Holds everything after the first space
-    std::string command_data;
-    // Parse command into command and its arguments
-    splitCommand(&command, &command_data);
-    // Holds command arguments, different for each command
-    std::vector <std::string> arguments;
-
-    // while the user doesn't type 'exit' command, keep asking for commands
-    while (command != "exit") {
-
-        arguments = splitByDelimiter(command_data, " ");
-
-        // Each command is handled in its own function
-        if (command == "create") {
-            // create <text_size> <data_size>
-            if (arguments.size() != 2) {
-                std::cout << command << " " << command_data << " is not a valid command." << std::endl;
-                std::cout << command << " " << command_data << " does not have the correct number of arguments."
-                          << std::endl;
-            } else {
-                int text_size = std::stoi(arguments[0]);
-                int data_size = std::stoi(arguments[1]);
-
-                create(text_size, data_size, mmu, pageTable, page_size);
-            }
-        } else if (command == "allocate") {
-            // allocate <PID> <var_name> <data_type> <number_of_elements>
-            if (arguments.size() != 4) {
-                std::cout << command << " " << command_data << " is not a valid command." << std::endl;
-                std::cout << command << " " << command_data << " does not have the correct number of arguments."
-                          << std::endl;
-            } else {
-                int pid = std::stoi(arguments[0]);
-                std::string var_name = arguments[1];
-                std::string data_type = arguments[2];
-                int number_of_elements = std::stoi(arguments[3]);
-
-                allocate(pid, var_name, data_type, number_of_elements, mmu, pageTable, page_size);
-                // allocate(1024, "var1", "int", 10, mmu, pageTable, page_size);
-            }
-        } else if (command == "set") {
-            // set <PID> <var_name> <offset> <value_0> <value_1> <value_2> ... <value_N>
-            if (arguments.size() < 4) {
-                std::cout << command << " " << command_data << " is not a valid command." << std::endl;
-                std::cout << command << " " << command_data << " does not have enough arguments." << std::endl;
-            } else {
-                int pid = std::stoi(arguments[0]);
-                std::string var_name = arguments[1];
-                int offset = std::stoi(arguments[2]);
-                std::vector <std::string> values;
-
-                for (int i = 3; i < arguments.size(); i++) {
-                    values.push_back(arguments[i]);
-                }
+    PageTable *pageTable = new PageTable(page_size, tlb, shard_count, page_table_layout);
+    pageTable->setPhysicalMemory(memory);
+    if (large_pages > 1) {
+        pageTable->enableLargePages(large_pages);
+    }
 
-                set(pid, var_name, offset, values, mmu, pageTable, page_size, memory);
-                // set(1024, "var1", 0, values, mmu, pageTable, page_size, memory);
-            }
-        } else if (command == "print") {
-            if (command_data == "mmu") {
-                mmu->print();
-            } else if (command_data == "page") {
-                pageTable->print();
-            } else if (command_data == "processes") {
-                mmu->printProcesses();
-            } else {
-                arguments = splitByDelimiter(command_data, ":");
-                int pid = std::stoi(arguments[0]);
-                std::string var_name = arguments[1];
-                printVariable(pid, var_name, mmu, pageTable, memory);
-                // <PID>:<var_name>
-            }
-        } else if (command == "free") {
-            // free <PID> <var_name>
-            if (arguments.size() != 2) {
-                std::cout << command << " " << command_data << " is not a valid command." << std::endl;
-                std::cout << command << " " << command_data << " does not have enough arguments." << std::endl;
-            } else {
-                int pid = std::stoi(arguments[0]);
-                std::string var_name = arguments[1];
-                free(pid, var_name, mmu, pageTable, page_size);
-            }
-        } else if (command == "terminate") {
-            if (arguments.size() != 1) {
-                std::cout << command << " " << command_data << " is not a valid command." << std::endl;
-                std::cout << command << " " << command_data << " does not have enough arguments." << std::endl;
-
-            } else {
-                int pid = std::stoi(arguments[0]);
-                terminate(pid, mmu, pageTable, page_size);
-            }
-        } else {
-            std::cout << command << " is not a valid command." << std::endl;
+    // Swap file for pages evicted once physical memory is full
+    if (!swap_path.empty()) {
+        SwapFile *swap = new SwapFile(swap_path, page_size);
+        if (!swap->isOpen()) {
+            fprintf(stderr, "Error: could not open swap file %s\n", swap_path.c_str());
+            return 1;
+        }
+        pageTable->enableSwap(swap, replacement_policy);
+    }
+
+    Simulator sim = {mmu, pageTable, tlb, page_size, memory};
+
+    // Start from a checkpoint instead of an empty simulator
+    if (!restore_path.empty()) {
+        std::string error;
+        if (!loadCheckpoint(restore_path.c_str(), &sim, &error)) {
+            fprintf(stderr, "Error: could not restore %s: %s\n", restore_path.c_str(), error.c_str());
+            return 1;
         }
+    }
 
-        // Get next command
+    if (!replay_path.empty()) {
+        // Replay mode: every access in the trace goes straight to the page table, no commands are run
+        if (!replayTrace(replay_path.c_str(), &sim)) {
+            fprintf(stderr, "Error: could not open trace %s\n", replay_path.c_str());
+            return 1;
+        }
+        std::cout.flush();
+    } else if (threads > 0) {
+        // Concurrent mode: every client thread is a core with a TLB of its own
+        std::vector<int> cores;
+        cores.push_back(0);
+        for (int i = 1; i < threads; i++) {
+            cores.push_back(pageTable->addCore(new Tlb(tlb_sets, tlb_ways, tlb_policy)));
+        }
+        runConcurrentWorkload(&sim, cores, operations);
+        std::cout.flush();
+    } else if (script != NULL) {
+        // Batch mode: no prompts, block-buffered output and a throughput summary at the end
+        auto start = std::chrono::steady_clock::now();
+        long commands = runScript(script, &sim);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout.flush();
+        fprintf(stderr, "Processed %ld commands in %.3f s (%.0f commands/s)\n", commands, elapsed.count(),
+                elapsed.count() > 0 ? commands / elapsed.count() : 0.0);
+        if (script != stdin) {
+            fclose(script);
+        }
+    } else {
+        // Prompt loop
+        // Your simulator should continually ask the user to input a command.
+        std::string command; // create, allocate, set, fill, copy, cmp, free, terminate, fork, share, save, load, print
         std::cout << "> ";
-        std::getline(std::cin, command);
+        // while the user doesn't type 'exit' command, keep asking for commands
+        while (std::getline(std::cin, command) && runCommand(&command[0], &sim)) {
+            std::cout << "> ";
+        }
+    }
 
-        command_data = "";
-        splitCommand(&command, &command_data);
+    // Dump the performance counters
+    if (stats_path == "-") {
+        printStats(std::cout);
+        std::cout.flush();
+    } else if (!stats_path.empty()) {
+        std::ofstream stats(stats_path.c_str());
+        if (!stats) {
+            fprintf(stderr, "Error: could not write stats to %s\n", stats_path.c_str());
+            return 1;
+        }
+        printStats(stats);
     }
 
     return 0;
 }
 
-// Splits the input command at the first space into a command and its arguments
-void splitCommand(std::string *first, std::string *second) {
-    std::string::size_type pos;
-    pos = first->find(' ', 0);
-    if (pos != std::string::npos) {
-        *second = first->substr(pos + 1);
-        *first = first->substr(0, pos);
+/*
+ * Runs one command line, returns false once the user asks to exit
+ * The line is tokenized in place
+ */
+bool runCommand(char *line, Simulator *sim) {
+    static CommandLine command; // reused so its arguments vector keeps its capacity
+    tokenizeCommand(line, &command);
+
+    if (strcmp(command.name, "exit") == 0) {
+        return false;
     }
-}
 
-// Splits the input command arguments with a space delimiter
-std::vector <std::string> splitByDelimiter(std::string data, std::string token) {
-    std::vector <std::string> result;
-    while (data.size()) {
-        int index = data.find(token);
-        if (index != std::string::npos) {
-            result.push_back(data.substr(0, index));
-            data = data.substr(index + token.size());
-            if (data.size() == 0) result.push_back(data);
-        } else {
-            result.push_back(data);
-            data = "";
+    // Each command is handled in its own function
+    for (int i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (strcmp(command.name, commands[i].name) == 0) {
+            STAT_SCOPE(commands[i].operation);
+            commands[i].handler(&command, sim);
+            return true;
         }
     }
-    return result;
-}
+    std::cout << command.name << " is not a valid command." << '\n';
 
-void printStartMessage(int page_size) {
-    std::cout << "Welcome to the Memory Allocation Simulator! Using a page size of " << page_size << " bytes."
-              << std::endl;
-    std::cout << "Commands:" << std::endl;
-    std::cout << "  * create <text_size> <data_size> (initializes a new process)" << std::endl;
-    std::cout << "  * allocate <PID> <var_name> <data_type> <number_of_elements> (allocated memory on the heap)"
-              << std::endl;
-    std::cout
-            << "  * set <PID> <var_name> <offset> <value_0> <value_1> <value_2> ... <value_N> (set the value for a variable)"
-            << std::endl;
-    std::cout << "  * free <PID> <var_name> (deallocate memory on the heap that is associated with <var_name>)"
-              << std::endl;
-    std::cout << "  * terminate <PID> (kill the specified process)" << std::endl;
-    std::cout << "  * print <object> (prints data)" << std::endl;
-    std::cout << "    * If <object> is \"mmu\", print the MMU memory table" << std::endl;
-    std::cout << "    * if <object> is \"page\", print the page table" << std::endl;
-    std::cout << "    * if <object> is \"processes\", print a list of PIDs for processes that are still running"
-              << std::endl;
-    std::cout << "    * if <object> is a \"<PID>:<var_name>\", print the value of the variable for that process"
-              << std::endl;
-    std::cout << std::endl;
+    return true;
 }
 
 /*
- * create <text_size> <data_size>
- * - Initializes a new process
- *   - Assign a PID - unique number (start at 1024 and increment up)
- *   - Allocate some amount of startup memory for the process
- *     - Text/Code: user specified number (2048 - 16384 bytes)
- *     - Data/Globals: user specified number (0 - 1024 bytes)
- *     - Stack: constant (65536 bytes)
- * - Prints the PID
- *
- * > create 5992 564
- * return: 1024
+ * Runs every command in a script, reading it in large chunks rather than a line at a time
+ * Returns the number of commands run
  */
-void create(int text_size, int data_size, Mmu *mmu, PageTable *pageTable, int page_size) {
-
-    // text_size needs to be between 2048 and 16384
-    // data_size needs to be between 0 and 1024
-    // Print error if not
-    if (text_size < 2048 || text_size > 16384 || data_size < 0 || data_size > 1024) {
-        std::cout << "Text/Code size needs to be between 2048 and 16384 bytes. ";
-        std::cout << "Data/Globals size needs to be between 0 and 1024 bytes. " << std::endl;
-        return;
+long runScript(FILE *script, Simulator *sim) {
+    std::vector<char> buffer(1 << 20);
+    std::string line; // carries a line that is split across two chunks
+    long commands = 0;
+    size_t length;
+    while ((length = fread(&buffer[0], 1, buffer.size(), script)) > 0) {
+        size_t line_start = 0;
+        for (size_t i = 0; i < length; i++) {
+            if (buffer[i] != '\n') {
+                continue;
+            }
+            // Lines that sit entirely inside the chunk are tokenized right where they are
+            buffer[i] = '\0';
+            char *text = &buffer[line_start];
+            if (!line.empty()) {
+                line.append(text);
+                text = &line[0];
+            }
+            line_start = i + 1;
+            if (!isBlank(text)) {
+                commands++;
+                if (!runCommand(text, sim)) {
+                    return commands;
+                }
+            }
+            line.clear();
+        }
+        line.append(&buffer[line_start], length - line_start);
     }
-    int stack_size = 65536; // Stack is constant 65536 bytes
-
-    // Create process and get returned the pid (process id)
-    int pid = mmu->createProcess(); // pid starts at 1024
-    std::cout << pid << std::endl;
+    // last line without a trailing newline
+    if (!isBlank(line.c_str())) {
+        commands++;
+        runCommand(&line[0], sim);
+    }
+    return commands;
+}
 
-    // Create <TEXT>, <GLOBALS>, and <STACK> variables
-    addVariable(pid, "<TEXT>", text_size, "char", mmu, pageTable, page_size);
-    addVariable(pid, "<GLOBALS>", data_size, "char", mmu, pageTable, page_size);
-    addVariable(pid, "<STACK>", stack_size, "char", mmu, pageTable, page_size);
+// True if a line has nothing but whitespace in it
+bool isBlank(const char *line) {
+    for (; *line != '\0'; line++) {
+        if (*line != ' ' && *line != '\t' && *line != '\r') {
+            return false;
+        }
+    }
+    return true;
 }
 
-/*
-Allocate memory on the heap
-  - N chars (N bytes)
-  - N shorts (N * 2 bytes)
-  - N ints / floats (N * 4 bytes)
-  - N longs / doubles (N * 8 bytes)
-
-allocate <PID> <var_name> <data_type> <number_of_elements>
-Allocated memory on the heap (how much depends on the data type and the number of elements)
-Print the virtual memory address
- */
-void allocate(int pid, std::string var_name, std::string data_type, int number_of_elements, Mmu *mmu, PageTable *pageTable, int page_size) {
-
-    std::map<std::string, int> data_type_map = {
-            {"char", 1},
-            {"short", 2},
-            {"int", 4},
-            {"float", 4},
-            {"long", 8},
-            {"double", 8}
-    };
-
-    if(data_type_map.count(data_type) == 0){
-        std::cout << data_type << " is not a valid data_type." << std::endl;
-        return;
+// Reports a command that could not be run as typed
+void printInvalidCommand(CommandLine *command, const char *reason) {
+    std::string text = joinCommand(command);
+    std::cout << text << " is not a valid command." << '\n';
+    if (reason != NULL) {
+        std::cout << text << " " << reason << '\n';
     }
+}
 
-    int number_of_bytes = number_of_elements;
-    number_of_bytes *= data_type_map[data_type];
+// create <text_size> <data_size>
+void createCommand(CommandLine *command, Simulator *sim) {
+    int text_size;
+    int data_size;
+    if (command->arguments.size() != 2) {
+        printInvalidCommand(command, "does not have the correct number of arguments.");
+    } else if (!parseInt(command->arguments[0], &text_size) || !parseInt(command->arguments[1], &data_size)) {
+        printInvalidCommand(command, NULL);
+    } else {
+        create(text_size, data_size, sim->mmu, sim->pageTable, sim->page_size);
+    }
+}
 
-    int var_virtual_address = addVariable(pid, var_name, number_of_bytes, data_type, mmu, pageTable, page_size);
-    // if can't fit in memory then error
-    if(var_virtual_address == -1) {
-        std::cout << "Allocation would exceed system memory. No allocation performed." << std::endl;
+// allocate <PID> <var_name> <data_type> <number_of_elements>
+void allocateCommand(CommandLine *command, Simulator *sim) {
+    int pid;
+    int number_of_elements;
+    if (command->arguments.size() != 4) {
+        printInvalidCommand(command, "does not have the correct number of arguments.");
+    } else if (!parseInt(command->arguments[0], &pid) || !parseInt(command->arguments[3], &number_of_elements)) {
+        printInvalidCommand(command, NULL);
     } else {
-        // print virtual address
-        std::cout << var_virtual_address << std::endl;
+        allocate(pid, command->arguments[1], command->arguments[2], number_of_elements, sim->mmu, sim->pageTable,
+                 sim->page_size);
     }
 }
 
-int addVariable(int pid, std::string var_name, int size, std::string type, Mmu *mmu, PageTable *pageTable, int page_size) {
-    // Use first fit algorithm within a page when allocating new data
-
-    // Add variable to process
-    int var_virtual_address = mmu->addVariableToProcess(pid, var_name, size, type);
-    // Allocation would exceed system memory. No allocation performed.
-    if(var_virtual_address != -1){
-        // Add pages needed to store variable
-        int starting_page = var_virtual_address / page_size;
-        // will always be on 1 page
-        int number_of_pages = 1;
-        // how much space it takes up on page that it partially fills
-        int reverse_offset = page_size - (var_virtual_address % page_size);
-        int size_after_first_page = (size - reverse_offset);
-        // number of pages past starting page that it needs to fit whole variable
-        if(size_after_first_page > 0){
-            number_of_pages += 1;
-            number_of_pages += size_after_first_page / page_size;
-        }
+// set <PID> <var_name> <offset> <value_0> <value_1> <value_2> ... <value_N>
+void setCommand(CommandLine *command, Simulator *sim) {
+    int pid;
+    int offset;
+    if (command->arguments.size() < 4) {
+        printInvalidCommand(command, "does not have enough arguments.");
+    } else if (!parseInt(command->arguments[0], &pid) || !parseInt(command->arguments[2], &offset)) {
+        printInvalidCommand(command, NULL);
+    } else {
+        // values are the arguments after the offset
+        set(pid, command->arguments[1], offset, &command->arguments[3], command->arguments.size() - 3, sim->mmu,
+            sim->pageTable, sim->page_size, sim->memory);
+    }
+}
 
-        for(int i = 0; i < number_of_pages; i++){
-            pageTable->addEntry(pid, starting_page + i);
+// print <object>
+void printCommand(CommandLine *command, Simulator *sim) {
+    if (command->arguments.size() != 1) {
+        printInvalidCommand(command, "does not have the correct number of arguments.");
+        return;
+    }
+    char *object = command->arguments[0];
+    if (strcmp(object, "mmu") == 0) {
+        sim->mmu->print();
+    } else if (strcmp(object, "page") == 0) {
+        sim->pageTable->print();
+    } else if (strcmp(object, "processes") == 0) {
+        sim->mmu->printProcesses();
+    } else if (strcmp(object, "tlb") == 0) {
+        sim->tlb->print(sim->page_size);
+    } else if (strcmp(object, "memory") == 0) {
+        sim->memory->print();
+    } else if (strcmp(object, "heap") == 0) {
+        sim->mmu->printHeap();
+    } else if (strcmp(object, "swap") == 0) {
+        sim->pageTable->printSwap();
+    } else if (strcmp(object, "ptes") == 0) {
+        sim->pageTable->printPtes();
+    } else if (strcmp(object, "ptmem") == 0) {
+        sim->pageTable->printMemory();
+    } else if (strcmp(object, "stats") == 0) {
+        printStats(std::cout);
+    } else {
+        // <PID>:<var_name>
+        char *var_name = splitToken(object, ':');
+        int pid;
+        if (var_name == NULL || !parseInt(object, &pid)) {
+            if (var_name != NULL) {
+                var_name[-1] = ':'; // put the line back together for the message
+            }
+            printInvalidCommand(command, NULL);
+            return;
         }
+        printVariable(pid, var_name, sim->mmu, sim->pageTable, sim->memory);
     }
-
-    return var_virtual_address;
 }
 
-void set(int pid, std::string var_name, int offset, std::vector <std::string> values, Mmu *mmu, PageTable *pageTable, int page_size, uint8_t *memory) {
-
-    Variable* variable = mmu->getVariableFromProcess(pid, var_name);
-
-    int virtual_address = variable->virtual_address;
-    std::string type = variable->type;
-    int physical_address = pageTable->getPhysicalAddress(pid, virtual_address);
-
-    if(type == "char"){
-        std::vector<char> new_values;
-        set_physical_data(physical_address, offset, values, new_values, type, 1, memory);
-    } else if(type == "short"){
-        std::vector<short> new_values;
-        set_physical_data(physical_address, offset, values, new_values, type, 2, memory);
-    } else if(type == "int"){
-        std::vector<int> new_values;
-        set_physical_data(physical_address, offset, values, new_values, type, 4, memory);
-    } else if(type == "float"){
-        std::vector<float> new_values;
-        set_physical_data(physical_address, offset, values, new_values, type, 4, memory);
-    } else if(type == "long"){
-        std::vector<long> new_values;
-        set_physical_data(physical_address, offset, values, new_values, type, 8, memory);
-    } else if(type == "double"){
-        std::vector<double> new_values;
-        set_physical_data(physical_address, offset, values, new_values, type, 8, memory);
+// free <PID> <var_name>
+void freeCommand(CommandLine *command, Simulator *sim) {
+    int pid;
+    if (command->arguments.size() != 2) {
+        printInvalidCommand(command, "does not have enough arguments.");
+    } else if (!parseInt(command->arguments[0], &pid)) {
+        printInvalidCommand(command, NULL);
+    } else {
+        free(pid, command->arguments[1], sim->mmu, sim->pageTable, sim->page_size);
     }
 }
 
-template<typename T>
-void set_physical_data(int physical_address, int offset, std::vector<std::string> values, std::vector<T> new_values, std::string type, int bytes, uint8_t *memory){
-    for(int i = 0; i < values.size(); i++){
-        if(type == "char"){
-            new_values.push_back(values[i].at(0));
-        } else if(type == "short"){
-            new_values.push_back(std::stoi(values[i]));
-        } else if(type == "int"){
-            new_values.push_back(std::stoi(values[i]));
-        } else if(type == "float"){
-            new_values.push_back(std::stof(values[i]));
-        } else if(type == "long"){
-            new_values.push_back(std::stol(values[i]));
-        } else if(type == "double"){
-            new_values.push_back(std::stod(values[i]));
-        }
+// terminate <PID>
+void terminateCommand(CommandLine *command, Simulator *sim) {
+    int pid;
+    if (command->arguments.size() != 1) {
+        printInvalidCommand(command, "does not have enough arguments.");
+    } else if (!parseInt(command->arguments[0], &pid)) {
+        printInvalidCommand(command, NULL);
+    } else {
+        terminate(pid, sim->mmu, sim->pageTable, sim->page_size);
     }
-    physical_address += (offset * bytes);
-    std::memcpy(&memory[physical_address], new_values.data(), new_values.size() * bytes);
 }
 
-void printVariable(int pid, std::string name, Mmu *mmu, PageTable *pageTable, uint8_t *memory){
-
-    Variable* variable = mmu->getVariableFromProcess(pid, name);
-
-    int virtual_address = variable->virtual_address;
-    int physical_address = pageTable->getPhysicalAddress(pid, virtual_address);
-
-    int size = variable->size;
-
-    std::string type = variable->type;
-
-    if(type == "char") {
-        std::vector<char> values;
-        print_physical_data(physical_address, size, 1, values, memory);
-    } else if(type == "short"){
-        std::vector<short> values;
-        print_physical_data(physical_address, size, 2, values, memory);
-    } else if(type == "int"){
-        std::vector<int> values;
-        print_physical_data(physical_address, size, 4, values, memory);
-    } else if(type == "float"){
-        std::vector<float> values;
-        print_physical_data(physical_address, size, 4, values, memory);
-    } else if(type == "long"){
-        std::vector<long> values;
-        print_physical_data(physical_address, size, 8, values, memory);
-    } else if(type == "double"){
-        std::vector<double> values;
-        print_physical_data(physical_address, size, 8, values, memory);
-    }
-    std::cout << std::endl;
+// fork <PID>
+void forkCommand(CommandLine *command, Simulator *sim) {
+    int pid;
+    if (command->arguments.size() != 1) {
+        printInvalidCommand(command, "does not have the correct number of arguments.");
+    } else if (!parseInt(command->arguments[0], &pid)) {
+        printInvalidCommand(command, NULL);
+    } else {
+        fork(pid, sim->mmu, sim->pageTable);
+    }
 }
 
-template<typename T>
-void print_physical_data(int physical_address, int size, int type_size, std::vector<T> values, uint8_t *memory){
-    int number_of_values = size / type_size;
-    values.resize(number_of_values);
-    std::memcpy(&values[0], &memory[physical_address], size);
+// share <PID_A> <var_name> <PID_B> <name>
+void shareCommand(CommandLine *command, Simulator *sim) {
+    int pid;
+    int target_pid;
+    if (command->arguments.size() != 4) {
+        printInvalidCommand(command, "does not have the correct number of arguments.");
+    } else if (!parseInt(command->arguments[0], &pid) || !parseInt(command->arguments[2], &target_pid)) {
+        printInvalidCommand(command, NULL);
+    } else {
+        share(pid, command->arguments[1], target_pid, command->arguments[3], sim->mmu, sim->pageTable,
+              sim->page_size, sim->memory);
+    }
+}
 
-    for(int i = 0; i < number_of_values; i++){
-        if(i > 3){
-            std::cout << "... [" << number_of_values << " items]";
-            break;
-        }
-        std::cout << values[i];
-        if(i < number_of_values-1){
-            std::cout << ", ";
-        }
+// save <file>
+void saveCommand(CommandLine *command, Simulator *sim) {
+    std::string error;
+    if (command->arguments.size() != 1) {
+        printInvalidCommand(command, "does not have the correct number of arguments.");
+    } else if (!saveCheckpoint(command->arguments[0], sim, &error)) {
+        std::cout << "Could not save " << command->arguments[0] << ", " << error << "." << '\n';
     }
 }
 
-void free(int pid, std::string name, Mmu *mmu, PageTable *pageTable, int page_size){
-    // Maybe check if variable exists first
-    Variable *variable = mmu->getVariableFromProcess(pid, name);
-    variable->name = "<FREE_SPACE>";
-
-    int size = variable->size;
-    int virtual_address = variable->virtual_address;
-
-    int first_page_number = virtual_address / page_size;
-    int last_page_number = (virtual_address + size) / page_size;
-
-    // remove table entries and frames
-    // only remove pages between first and last pages
-    for(int page = first_page_number+1; page < last_page_number; page++){
-        pageTable->removeEntry(pid, page);
-        // std::cout << "remove " << page << std::endl;
-    }
-
-    // remove first and last pages if there are no other variables on those pages
-    Process *process = mmu->getProcess(pid);
-    std::vector<Variable*> variables = process->variables;
-
-    bool first_has_variables = false;
-    bool last_has_variables = false;
-
-    for (int i = 0; i < variables.size(); i++) {
-        if(variables[i]->name != "<FREE_SPACE>") {
-            int virtual_address = variables[i]->virtual_address;
-            int size = variables[i]->size;
-            // first and last pages that this free space variable is on
-            int starting_page = virtual_address / page_size;
-            int ending_page = (virtual_address + size) / page_size;
-            // checks if there is a variable on first or last page of newly freed variable
-            if (starting_page == first_page_number || ending_page == first_page_number) {
-                first_has_variables = true;
-            }
-            if (starting_page == last_page_number || ending_page == last_page_number) {
-                last_has_variables = true;
-            }
-        }
+// load <file>
+void loadCommand(CommandLine *command, Simulator *sim) {
+    std::string error;
+    if (command->arguments.size() != 1) {
+        printInvalidCommand(command, "does not have the correct number of arguments.");
+    } else if (!loadCheckpoint(command->arguments[0], sim, &error)) {
+        std::cout << "Could not load " << command->arguments[0] << ", " << error << "." << '\n';
     }
-    // Remove table entry if there are no variables on that page
-    if(!first_has_variables){
-        pageTable->removeEntry(pid, first_page_number);
+}
+
+// fill <PID> <var_name> <offset> <count> <value>
+void fillCommand(CommandLine *command, Simulator *sim) {
+    int pid;
+    int offset;
+    int count;
+    if (command->arguments.size() != 5) {
+        printInvalidCommand(command, "does not have the correct number of arguments.");
+    } else if (!parseInt(command->arguments[0], &pid) || !parseInt(command->arguments[2], &offset) ||
+               !parseInt(command->arguments[3], &count)) {
+        printInvalidCommand(command, NULL);
+    } else {
+        fill(pid, command->arguments[1], offset, count, command->arguments[4], sim->mmu, sim->pageTable,
+             sim->memory);
     }
-    if(!last_has_variables){
-        pageTable->removeEntry(pid, last_page_number);
+}
+
+// copy <PID_A> <source> <PID_B> <destination> <count>
+void copyCommand(CommandLine *command, Simulator *sim) {
+    int source_pid;
+    int destination_pid;
+    int count;
+    if (command->arguments.size() != 5) {
+        printInvalidCommand(command, "does not have the correct number of arguments.");
+    } else if (!parseInt(command->arguments[0], &source_pid) || !parseInt(command->arguments[2], &destination_pid) ||
+               !parseInt(command->arguments[4], &count)) {
+        printInvalidCommand(command, NULL);
+    } else {
+        copy(source_pid, command->arguments[1], destination_pid, command->arguments[3], count, sim->mmu,
+             sim->pageTable, sim->memory);
     }
+}
 
-    // find all free space and join if possible
-    mmu->joinFreeSpace(pid);
+// cmp <PID_A> <var_a> <PID_B> <var_b> <count>
+void compareCommand(CommandLine *command, Simulator *sim) {
+    int pid_a;
+    int pid_b;
+    int count;
+    if (command->arguments.size() != 5) {
+        printInvalidCommand(command, "does not have the correct number of arguments.");
+    } else if (!parseInt(command->arguments[0], &pid_a) || !parseInt(command->arguments[2], &pid_b) ||
+               !parseInt(command->arguments[4], &count)) {
+        printInvalidCommand(command, NULL);
+    } else {
+        compare(pid_a, command->arguments[1], pid_b, command->arguments[3], count, sim->mmu, sim->pageTable,
+                sim->memory);
+    }
 }
 
-void terminate(int pid, Mmu *mmu, PageTable *pageTable, int page_size){
-    mmu->terminateProcess(pid);
-    pageTable->removeProcess(pid);
+void printStartMessage(int page_size) {
+    std::cout << "Welcome to the Memory Allocation Simulator! Using a page size of " << page_size << " bytes."
+              << '\n';
+    std::cout << "Commands:" << '\n';
+    std::cout << "  * create <text_size> <data_size> (initializes a new process)" << '\n';
+    std::cout << "  * allocate <PID> <var_name> <data_type> <number_of_elements> (allocated memory on the heap)"
+              << '\n';
+    std::cout
+            << "  * set <PID> <var_name> <offset> <value_0> <value_1> <value_2> ... <value_N> (set the value for a variable)"
+            << '\n';
+    std::cout << "  * free <PID> <var_name> (deallocate memory on the heap that is associated with <var_name>)"
+              << '\n';
+    std::cout << "  * terminate <PID> (kill the specified process)" << '\n';
+    std::cout << "  * fork <PID> (copy a process, pages are shared until written)" << '\n';
+    std::cout << "  * share <PID_A> <var_name> <PID_B> <name> (map a variable of process A into process B)" << '\n';
+    std::cout << "  * save <file> (write a checkpoint of every process and frame)" << '\n';
+    std::cout << "  * load <file> (replace every process with the ones in a checkpoint)" << '\n';
+    std::cout << "  * fill <PID> <var_name> <offset> <count> <value> (set count values of a variable to one value)"
+              << '\n';
+    std::cout << "  * copy <PID_A> <source> <PID_B> <destination> <count> (copy values between variables)" << '\n';
+    std::cout << "  * cmp <PID_A> <var_a> <PID_B> <var_b> <count> (compare values of two variables)" << '\n';
+    std::cout << "  * print <object> (prints data)" << '\n';
+    std::cout << "    * If <object> is \"mmu\", print the MMU memory table" << '\n';
+    std::cout << "    * if <object> is \"page\", print the page table" << '\n';
+    std::cout << "    * if <object> is \"processes\", print a list of PIDs for processes that are still running"
+              << '\n';
+    std::cout << "    * if <object> is \"memory\", print reserved and committed physical memory" << '\n';
+    std::cout << "    * if <object> is \"heap\", print the allocation policy and free space of each process" << '\n';
+    std::cout << "    * if <object> is \"tlb\", print TLB hits, misses and hit rate for each process" << '\n';
+    std::cout << "    * if <object> is \"swap\", print page faults, evictions and swap file I/O" << '\n';
+    std::cout << "    * if <object> is \"ptes\", print page table entries used with and without large pages" << '\n';
+    std::cout << "    * if <object> is \"ptmem\", print the bytes spent on each process's page table" << '\n';
+    std::cout << "    * if <object> is \"stats\", print call counts and latencies of commands and core operations"
+              << '\n';
+    std::cout << "    * if <object> is a \"<PID>:<var_name>\", print the value of the variable for that process"
+              << '\n';
+    std::cout << '\n';
 }
@@ -1,142 +1,436 @@
 #include "mmu.h"
+#include "conditionallock.h"
+#include "stats.h"
 #include <iomanip>
+#include <chrono>
+#include <type_traits>
 
-Mmu::Mmu(int memory_size) {
-    _next_pid = 1024;
+// Name every <FREE_SPACE> block points at
+static const std::string free_space_name = "<FREE_SPACE>";
+
+// Blocks are freed with their process's pool without being visited
+static_assert(std::is_trivially_destructible<Variable>::value, "Variable must not need its destructor run");
+
+Mmu::Mmu(int memory_size, AllocationPolicy policy, int shard_count) {
+    _first_pid = 1024;
+    _next_pid = _first_pid;
     _max_size = memory_size;
+    _policy = policy;
+    _allocations = 0;
+    _failed_allocations = 0;
+    _allocation_time_ns = 0;
+    _shard_count = shard_count;
+    _concurrent = shard_count > 1;
+    _shards = new ProcessShard[shard_count];
 }
 
 Mmu::~Mmu() {
-    // destructor
+    clear();
+    delete[] _shards;
+}
+
+// Terminates every process, pids are not handed out again
+void Mmu::clear() {
+    for (int i = 0; i < _shard_count; i++) {
+        for (int j = 0; j < _shards[i].processes.size(); j++) {
+            deleteProcess(_shards[i].processes[j]);
+        }
+        _shards[i].processes.clear();
+    }
 }
 
 uint32_t Mmu::createProcess() {
-    Process *newProcess = new Process();
-    newProcess->pid = _next_pid; // Assign a PID
+    Process *newProcess = allocateProcess(_next_pid++); // Assign a PID, and increment pid for next process
 
     // Initialize process with empty FREE_SPACE variable which is the size of memory
-    Variable *var = new Variable();
-    var->name = "<FREE_SPACE>";
-    var->virtual_address = 0;
-    var->size = _max_size;
-    newProcess->variables.push_back(var);
+    Variable *var = createVariable(newProcess, 0, _max_size, TYPE_NONE);
+    var->is_free = true;
+    newProcess->first_variable = var;
+    newProcess->free_space.insert(var);
 
-    _processes.push_back(newProcess); // Push process onto back of processes Vector
-
-    _next_pid++; // increment pid for next process
+    addProcess(newProcess);
 
     return newProcess->pid;
 }
 
+/*
+ * Creates a process with a copy of another process's variables and free space at the same addresses
+ * Returns the new pid, or -1 if there is no such running process
+ */
+int Mmu::forkProcess(int parent_pid) {
+    Process *parent = getProcess(parent_pid);
+    if (parent == NULL) {
+        return -1;
+    }
+    Process *child = allocateProcess(_next_pid++);
+
+    Variable *last = NULL;
+    for (Variable *var = parent->first_variable; var != NULL; var = var->next) {
+        Variable *copy = createVariable(child, var->virtual_address, var->size, var->type);
+        copy->is_free = var->is_free;
+        copy->padding_before = var->padding_before;
+        copy->padding_after = var->padding_after;
+        copy->prev = last;
+        if (last != NULL) {
+            last->next = copy;
+        } else {
+            child->first_variable = copy;
+        }
+        last = copy;
+        if (copy->is_free) {
+            child->free_space.insert(copy);
+        } else {
+            nameVariable(child, copy, *var->name);
+        }
+    }
+
+    addProcess(child);
+
+    return child->pid;
+}
+
+// Shard the process with the given pid is in, pid is at least the first pid
+ProcessShard *Mmu::getShard(uint32_t pid) {
+    return &_shards[(pid - _first_pid) % _shard_count];
+}
+
+// Takes a process with no blocks from the pool of its shard, it is not in the process table yet
+Process *Mmu::allocateProcess(uint32_t pid) {
+    ProcessShard *shard = getShard(pid);
+    ConditionalLock lock(shard->lock, _concurrent);
+    Process *process = shard->process_pool.allocate();
+    process->pid = pid;
+    process->first_variable = NULL;
+    return process;
+}
+
+// Puts a new process in its slot of the process table
+void Mmu::addProcess(Process *process) {
+    uint32_t index = process->pid - _first_pid;
+    ProcessShard *shard = getShard(process->pid);
+    ConditionalLock lock(shard->lock, _concurrent);
+    if (index / _shard_count >= shard->processes.size()) {
+        shard->processes.resize(index / _shard_count + 1, NULL);
+    }
+    shard->processes[index / _shard_count] = process;
+}
+
 void Mmu::terminateProcess(int term_pid) {
-    for (int i = 0; i < _processes.size(); i++) {
-        if(_processes[i]->pid == term_pid){
-            _processes.erase(_processes.begin() + i);
-            break;
+    if (term_pid < (int)_first_pid) {
+        return;
+    }
+    uint32_t index = term_pid - _first_pid;
+    ProcessShard *shard = &_shards[index % _shard_count];
+    Process *process = NULL;
+    {
+        ConditionalLock lock(shard->lock, _concurrent);
+        if (index / _shard_count < shard->processes.size()) {
+            process = shard->processes[index / _shard_count];
+            shard->processes[index / _shard_count] = NULL;
         }
     }
+    deleteProcess(process);
+}
+
+// Frees a process, its variables go with its pool of blocks
+void Mmu::deleteProcess(Process *process) {
+    if (process == NULL) {
+        return;
+    }
+    ProcessShard *shard = getShard(process->pid);
+    ConditionalLock lock(shard->lock, _concurrent);
+    shard->process_pool.release(process);
 }
 
+/*
+ * Returns the process with the given pid, or NULL if there is no such running process
+ */
 Process *Mmu::getProcess(int pid) {
-    for (int i = 0; i < _processes.size(); i++) {
-        if (_processes[i]->pid == pid) {
-            return _processes[i];
-        }
+    if (pid < (int)_first_pid) {
+        return NULL;
     }
+    uint32_t index = pid - _first_pid;
+    ProcessShard *shard = &_shards[index % _shard_count];
+    ConditionalLock lock(shard->lock, _concurrent);
+    if (index / _shard_count >= shard->processes.size()) {
+        return NULL;
+    }
+    return shard->processes[index / _shard_count];
 }
 
-int Mmu::addVariableToProcess(int pid, std::string name, int size, std::string type) {
+int Mmu::addVariableToProcess(int pid, std::string name, int size, DataType type) {
+    STAT_SCOPE(STAT_HEAP_ALLOCATE);
+    Process* process = getProcess(pid);
+    if(process == NULL){
+        return -1;
+    }
+
+    // Ask the free space index for a block using the allocation policy
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Variable *free_space_var = process->free_space.find(size, _policy);
+    _allocation_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    _allocations++;
+    // if no free space to put variable then return -1, meaning it would exceed system memory
+    if(free_space_var == NULL){
+        _failed_allocations++;
+        return -1;
+    }
+
+    return placeVariable(process, free_space_var, name, size, type)->virtual_address;
+}
+
+/*
+ * Adds a variable on pages of its own, with its data page_offset bytes into the first page
+ * The rest of those pages is padding, so no other variable can be put on them
+ * Returns the virtual address of the data, or -1 if no free block can hold the pages
+ */
+int Mmu::addPageAlignedVariableToProcess(int pid, std::string name, int size, DataType type, int page_size,
+                                         int page_offset) {
+    STAT_SCOPE(STAT_HEAP_ALLOCATE);
     Process* process = getProcess(pid);
+    if(process == NULL){
+        return -1;
+    }
+
+    int pages = size > 0 ? (page_offset + size - 1) / page_size + 1 : 1;
+    int block_size = pages * page_size;
 
-    int virtual_address = calculateVirtualAddress(process, size);
-    if(virtual_address == -1){
-        return virtual_address;
+    // a block this big has room for the pages wherever it starts
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Variable *free_space_var = process->free_space.find(block_size + page_size - 1, _policy);
+    _allocation_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    _allocations++;
+    if(free_space_var == NULL){
+        _failed_allocations++;
+        return -1;
     }
-    Variable *new_var = createVariable(name, virtual_address, size, type);
 
-    // take free space off back
-    Variable *free_space_var = process->variables[process->variables.size() - 1];
-    process->variables.pop_back();
+    alignFreeBlock(process, free_space_var, page_size);
+    Variable *new_var = placeVariable(process, free_space_var, name, block_size, type);
+    new_var->virtual_address += page_offset;
+    new_var->size = size;
+    new_var->padding_before = page_offset;
+    new_var->padding_after = block_size - page_offset - size;
 
-    // add new variable to variables vector
-    process->variables.push_back(new_var);
+    return new_var->virtual_address;
+}
 
-    // add free space back on
-    process->variables.push_back(free_space_var);
+/*
+ * Adds a variable that starts on a multiple of alignment, so it covers whole large pages
+ * Falls back to an unaligned block if no free block has room for an aligned one
+ * Returns the virtual address of the variable, or -1 if no free block can hold it
+ */
+int Mmu::addAlignedVariableToProcess(int pid, std::string name, int size, DataType type, int alignment) {
+    STAT_SCOPE(STAT_HEAP_ALLOCATE);
+    Process* process = getProcess(pid);
+    if(process == NULL){
+        return -1;
+    }
 
-    return virtual_address;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Variable *free_space_var = process->free_space.find(size + alignment - 1, _policy);
+    bool aligned = free_space_var != NULL;
+    if(!aligned){
+        free_space_var = process->free_space.find(size, _policy);
+    }
+    _allocation_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    _allocations++;
+    if(free_space_var == NULL){
+        _failed_allocations++;
+        return -1;
+    }
+
+    if(aligned){
+        alignFreeBlock(process, free_space_var, alignment);
+    }
+    return placeVariable(process, free_space_var, name, size, type)->virtual_address;
 }
 
-int Mmu::calculateVirtualAddress(Process* process, int size){
-    std::vector<Variable *> variables = process->variables;
-    for (int i = 0; i < variables.size(); i++) {
-        if(variables[i]->name == "<FREE_SPACE>") {
-            // Will variable fit in this free space?
-            if (variables[i]->size >= size) {
-                int virtual_address = variables[i]->virtual_address;
-                // change free space address
-                variables[i]->virtual_address += size;
-                // update free space size
-                variables[i]->size -= size;
-                return virtual_address;
-            }
+// Leaves the part of a free block before its first multiple of alignment as a free block of its own
+void Mmu::alignFreeBlock(Process *process, Variable *free_space_var, int alignment) {
+    int block_address = (int)(((long)free_space_var->virtual_address + alignment - 1) / alignment * alignment);
+    int lead = block_address - free_space_var->virtual_address;
+    if(lead == 0){
+        return;
+    }
+    Variable *lead_var = createVariable(process, free_space_var->virtual_address, lead, TYPE_NONE);
+    lead_var->is_free = true;
+    lead_var->prev = free_space_var->prev;
+    lead_var->next = free_space_var;
+    if(lead_var->prev != NULL){
+        lead_var->prev->next = lead_var;
+    } else {
+        process->first_variable = lead_var;
+    }
+    free_space_var->prev = lead_var;
+    process->free_space.remove(free_space_var);
+    free_space_var->virtual_address += lead;
+    free_space_var->size -= lead;
+    process->free_space.insert(free_space_var);
+    process->free_space.insert(lead_var);
+}
+
+// Carves a variable off the front of a free block, the block is deleted if nothing is left of it
+Variable *Mmu::placeVariable(Process *process, Variable *free_space_var, std::string name, int size,
+                             DataType type) {
+    int virtual_address = free_space_var->virtual_address;
+    Variable *new_var = createVariable(process, virtual_address, size, type);
+    nameVariable(process, new_var, name);
+
+    // new variable goes right in front of the free space it was carved from
+    new_var->prev = free_space_var->prev;
+    new_var->next = free_space_var;
+    if(new_var->prev != NULL){
+        new_var->prev->next = new_var;
+    } else {
+        process->first_variable = new_var;
+    }
+    free_space_var->prev = new_var;
+
+    // take the variable off the front of the free space
+    process->free_space.remove(free_space_var);
+    free_space_var->virtual_address += size;
+    free_space_var->size -= size;
+    if(free_space_var->size > 0){
+        process->free_space.insert(free_space_var);
+    } else {
+        new_var->next = free_space_var->next;
+        if(new_var->next != NULL){
+            new_var->next->prev = new_var;
         }
+        process->blocks.release(free_space_var);
     }
-    // if no free space to put variable then return -1, meaning it would exceed system memory
-    return -1;
+
+    return new_var;
 }
 
-Variable *Mmu::createVariable(std::string name, int address, int size, std::string type) {
-//    std::cout << name << " created at virtual address " << address << std::endl;
-    Variable *var = new Variable();
-    var->name = name;
+// Takes a block from the process's pool, it is named <FREE_SPACE> until it is given a name
+Variable *Mmu::createVariable(Process *process, int address, int size, DataType type) {
+    Variable *var = process->blocks.allocate();
+    var->name = &free_space_name;
     var->virtual_address = address;
     var->size = size;
     var->type = type;
+    var->is_free = false;
+    var->padding_before = 0;
+    var->padding_after = 0;
+    var->prev = NULL;
+    var->next = NULL;
     return var;
 }
 
-Variable *Mmu::getVariableFromProcess(int pid, std::string name){
+// Puts a variable in the process's name index and points its name at the key
+void Mmu::nameVariable(Process *process, Variable *variable, const std::string &name) {
+    std::unordered_map<std::string, Variable *>::iterator it =
+            process->variables_by_name.insert(std::make_pair(name, variable)).first;
+    it->second = variable;
+    variable->name = &it->first;
+}
+
+// Gives a variable a name that is not in use in its process
+void Mmu::renameVariable(int pid, Variable *variable, const std::string &name) {
     Process *process = getProcess(pid);
-    std::vector<Variable*> variables = process->variables;
-    for (int i = 0; i < variables.size(); i++) {
-        if (variables[i]->name == name) {
-            return variables[i];
-        }
+    if (process == NULL) {
+        return;
     }
+    std::string old_name = *variable->name;
+    nameVariable(process, variable, name);
+    process->variables_by_name.erase(old_name);
 }
 
-void Mmu::joinFreeSpace(int pid){
+/*
+ * Returns the named variable, or NULL if the process or variable does not exist
+ */
+Variable *Mmu::getVariableFromProcess(int pid, const std::string &name){
+    STAT_SCOPE(STAT_VARIABLE_LOOKUP);
     Process *process = getProcess(pid);
-    int prev_free_space_index = -1;
-    for (int i = 0; i < process->variables.size(); i++) {
-        if (process->variables[i]->name == "<FREE_SPACE>") {
-            if(prev_free_space_index != -1){
-                process->variables[prev_free_space_index]->size += process->variables[i]->size;
-                // remove absorbed free space variable
-                process->variables.erase(process->variables.begin() + i);
-                i--;
-            } else {
-                prev_free_space_index = i;
-            }
-        } else {
-            prev_free_space_index = -1;
+    if (process == NULL) {
+        return NULL;
+    }
+    std::unordered_map<std::string, Variable *>::iterator it = process->variables_by_name.find(name);
+    if (it == process->variables_by_name.end()) {
+        return NULL;
+    }
+    return it->second;
+}
+
+/*
+ * Turns a variable back into free space and merges it with any free space next to it
+ */
+void Mmu::freeVariable(int pid, Variable *variable){
+    Process *process = getProcess(pid);
+    if (process == NULL) {
+        return;
+    }
+    // the name is the index key, so it is pointed away from the key before the key goes
+    std::unordered_map<std::string, Variable *>::iterator it = process->variables_by_name.find(*variable->name);
+    variable->name = &free_space_name;
+    process->variables_by_name.erase(it);
+    variable->type = TYPE_NONE;
+    variable->is_free = true;
+    // the padding around a shared segment is freed with it
+    variable->virtual_address -= variable->padding_before;
+    variable->size += variable->padding_before + variable->padding_after;
+    variable->padding_before = 0;
+    variable->padding_after = 0;
+    process->free_space.insert(variable);
+    joinFreeSpace(process, variable);
+}
+
+/*
+ * Merges a free block with the blocks directly before and after it if they are free too
+ * Only the two neighbours are looked at so this does not depend on how many variables the process has
+ * Returns the merged block
+ */
+Variable *Mmu::joinFreeSpace(Process *process, Variable *free_space_var){
+    STAT_SCOPE(STAT_COALESCE);
+    // absorb the following block
+    Variable *next = free_space_var->next;
+    if (next != NULL && next->is_free) {
+        process->free_space.remove(free_space_var);
+        process->free_space.remove(next);
+        free_space_var->size += next->size;
+        free_space_var->next = next->next;
+        if (free_space_var->next != NULL) {
+            free_space_var->next->prev = free_space_var;
         }
+        process->blocks.release(next);
+        process->free_space.insert(free_space_var);
     }
+    // get absorbed by the preceding block
+    Variable *prev = free_space_var->prev;
+    if (prev != NULL && prev->is_free) {
+        process->free_space.remove(prev);
+        process->free_space.remove(free_space_var);
+        prev->size += free_space_var->size;
+        prev->next = free_space_var->next;
+        if (prev->next != NULL) {
+            prev->next->prev = prev;
+        }
+        process->blocks.release(free_space_var);
+        process->free_space.insert(prev);
+        free_space_var = prev;
+    }
+    return free_space_var;
 }
 
 void Mmu::print() {
-    int i, j;
-
-    std::cout << " PID  | Variable Name | Virtual Addr | Size" << std::endl;
-    std::cout << "------+---------------+--------------+------------" << std::endl;
-    for (i = 0; i < _processes.size(); i++) {
-        for (j = 0; j < _processes[i]->variables.size(); j++) {
-            std::string name = _processes[i]->variables[j]->name;
-            if (name != "<FREE_SPACE>") {
+    std::cout << " PID  | Variable Name | Virtual Addr | Size" << '\n';
+    std::cout << "------+---------------+--------------+------------" << '\n';
+    for (uint32_t pid = _first_pid; pid < _next_pid; pid++) {
+        Process *process = getProcess(pid);
+        if (process == NULL) {
+            continue;
+        }
+        for (Variable *var = process->first_variable; var != NULL; var = var->next) {
+            const std::string &name = *var->name;
+            if (!var->is_free) {
                 // pid
                 std::cout   << " "
-                            << _processes[i]->pid
+                            << process->pid
                             << " | ";
                 // name
                 std::cout   << std::left
@@ -151,7 +445,7 @@ void Mmu::print() {
                             << std::setw(8)
                             << std::hex
                             << std::uppercase
-                            << _processes[i]->variables[j]->virtual_address
+                            << var->virtual_address
                             << " | ";
                 // reset to decimal and fill to nothing
                 std::cout   << std::dec
@@ -159,9 +453,9 @@ void Mmu::print() {
                 // size
                 std::cout   << std::right
                             << std::setw(10)
-                            << _processes[i]->variables[j]->size;
+                            << var->size;
                 // end line
-                std::cout<< std::endl;
+                std::cout<< '\n';
             }
         }
     }
@@ -172,7 +466,153 @@ void Mmu::print() {
  * initiated by command 'print processes'
  */
 void Mmu::printProcesses() {
-    for (int i = 0; i < _processes.size(); i++) {
-        std::cout << _processes[i]->pid << std::endl;
+    for (uint32_t pid = _first_pid; pid < _next_pid; pid++) {
+        Process *process = getProcess(pid);
+        if (process == NULL) {
+            continue;
+        }
+        std::cout << process->pid << '\n';
+    }
+}
+
+/*
+ * Print the allocation policy with its average allocation time, then each process's free space
+ * Fragmentation is the share of free bytes that are not in the largest free block
+ * initiated by command 'print heap'
+ */
+void Mmu::printHeap() {
+    const char *policy_names[] = {"first-fit", "next-fit", "best-fit", "worst-fit"};
+    long allocations = _allocations;
+    std::cout << "Allocation policy: " << policy_names[_policy] << ", " << allocations << " allocations ("
+              << _failed_allocations << " failed), "
+              << (allocations > 0 ? _allocation_time_ns / allocations : 0) << " ns average" << '\n';
+
+    long blocks = 0;
+    long names = 0;
+    long pool_bytes = 0;
+    for (uint32_t pid = _first_pid; pid < _next_pid; pid++) {
+        Process *process = getProcess(pid);
+        if (process != NULL) {
+            blocks += process->blocks.getLiveCount();
+            names += process->variables_by_name.size();
+            pool_bytes += process->blocks.getBytes();
+        }
+    }
+    std::cout << "Metadata: " << blocks << " blocks and " << names << " names, " << pool_bytes
+              << " bytes of block pools" << '\n';
+
+    std::cout << " PID  | Free Blocks |  Free Bytes  | Largest Block | Fragmentation" << '\n';
+    std::cout << "------+-------------+--------------+---------------+---------------" << '\n';
+    for (uint32_t pid = _first_pid; pid < _next_pid; pid++) {
+        Process *process = getProcess(pid);
+        if (process == NULL) {
+            continue;
+        }
+        FreeSpace *free_space = &process->free_space;
+        long free_bytes = free_space->getFreeBytes();
+        double fragmentation = free_bytes > 0 ? 1.0 - (double)free_space->getLargestBlock() / free_bytes : 0.0;
+        std::cout << " " << process->pid << " | ";
+        std::cout << std::setw(11) << std::right << free_space->getBlockCount() << " | ";
+        std::cout << std::setw(12) << std::right << free_bytes << " | ";
+        std::cout << std::setw(13) << std::right << free_space->getLargestBlock() << " | ";
+        std::cout << std::setw(12) << std::right << std::fixed << std::setprecision(2)
+                  << 100.0 * fragmentation << "%" << '\n';
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+}
+
+/*
+ * Writes every running process and its blocks, free ones included, in address order
+ * The free space index and name index are rebuilt from the blocks on load
+ */
+void Mmu::save(CheckpointWriter *writer) {
+    writer->write<uint32_t>(_next_pid);
+    writer->write<int64_t>(_allocations);
+    writer->write<int64_t>(_failed_allocations);
+    std::vector<Process *> processes;
+    for (uint32_t pid = _first_pid; pid < _next_pid; pid++) {
+        Process *process = getProcess(pid);
+        if (process != NULL) {
+            processes.push_back(process);
+        }
+    }
+    writer->write<uint32_t>(processes.size());
+    for (int i = 0; i < processes.size(); i++) {
+        Process *process = processes[i];
+        uint32_t blocks = 0;
+        for (Variable *var = process->first_variable; var != NULL; var = var->next) {
+            blocks++;
+        }
+        writer->write<uint32_t>(process->pid);
+        writer->write<int32_t>(process->free_space.getNextFitAddress());
+        writer->write<uint32_t>(blocks);
+        for (Variable *var = process->first_variable; var != NULL; var = var->next) {
+            writer->writeString(*var->name);
+            writer->write<int32_t>(var->virtual_address);
+            writer->write<int32_t>(var->size);
+            writer->write<uint8_t>(var->type);
+            writer->write<uint8_t>(var->is_free);
+            writer->write<int32_t>(var->padding_before);
+            writer->write<int32_t>(var->padding_after);
+        }
+    }
+}
+
+// Replaces every process with the ones in a checkpoint, returns false if it is cut short
+bool Mmu::load(CheckpointReader *reader) {
+    clear();
+    uint32_t next_pid;
+    int64_t allocations;
+    int64_t failed_allocations;
+    uint32_t count;
+    if (!reader->read(&next_pid) || !reader->read(&allocations) || !reader->read(&failed_allocations) ||
+            !reader->read(&count) || next_pid < _first_pid) {
+        return false;
+    }
+    _next_pid = next_pid;
+    _allocations = allocations;
+    _failed_allocations = failed_allocations;
+    _allocation_time_ns = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t pid;
+        int32_t next_fit_address;
+        uint32_t blocks;
+        if (!reader->read(&pid) || !reader->read(&next_fit_address) || !reader->read(&blocks) ||
+                pid < _first_pid || pid >= next_pid) {
+            return false;
+        }
+        Process *process = allocateProcess(pid);
+        process->free_space.setNextFitAddress(next_fit_address);
+        addProcess(process);
+        Variable *last = NULL;
+        for (uint32_t j = 0; j < blocks; j++) {
+            Variable *var = createVariable(process, 0, 0, TYPE_NONE);
+            std::string name;
+            uint8_t type;
+            uint8_t is_free;
+            // link the block in first so it is freed with the process if the rest is missing
+            var->prev = last;
+            if (last != NULL) {
+                last->next = var;
+            } else {
+                process->first_variable = var;
+            }
+            last = var;
+            if (!reader->readString(&name) || !reader->read(&var->virtual_address) ||
+                    !reader->read(&var->size) || !reader->read(&type) || !reader->read(&is_free) ||
+                    !reader->read(&var->padding_before) || !reader->read(&var->padding_after) ||
+                    type >= DATA_TYPE_COUNT) {
+                return false;
+            }
+            var->type = (DataType)type;
+            var->is_free = is_free != 0;
+            if (var->is_free) {
+                process->free_space.insert(var);
+            } else {
+                nameVariable(process, var, name);
+            }
+        }
     }
+    return true;
 }
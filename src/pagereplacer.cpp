@@ -0,0 +1,100 @@
+#include "pagereplacer.h"
+
+PageReplacer::PageReplacer(int frame_count, ReplacementPolicy policy) {
+    _policy = policy;
+    _prev.resize(frame_count, -1);
+    _next.resize(frame_count, -1);
+    _resident.resize(frame_count, false);
+    _referenced.resize(frame_count, false);
+    _front = -1;
+    _back = -1;
+    _hand = 0;
+}
+
+PageReplacer::~PageReplacer() {
+}
+
+ReplacementPolicy PageReplacer::getPolicy() {
+    return _policy;
+}
+
+void PageReplacer::append(int frame) {
+    _prev[frame] = _back;
+    _next[frame] = -1;
+    if (_back != -1) {
+        _next[_back] = frame;
+    } else {
+        _front = frame;
+    }
+    _back = frame;
+}
+
+void PageReplacer::unlink(int frame) {
+    if (_prev[frame] != -1) {
+        _next[_prev[frame]] = _next[frame];
+    } else {
+        _front = _next[frame];
+    }
+    if (_next[frame] != -1) {
+        _prev[_next[frame]] = _prev[frame];
+    } else {
+        _back = _prev[frame];
+    }
+}
+
+// A page has been loaded into the frame
+void PageReplacer::loaded(int frame) {
+    _resident[frame] = true;
+    _referenced[frame] = true;
+    if (_policy != REPLACE_CLOCK) {
+        append(frame);
+    }
+}
+
+// The page in the frame has been read or written
+void PageReplacer::accessed(int frame) {
+    if (!_resident[frame]) {
+        return;
+    }
+    _referenced[frame] = true;
+    if (_policy == REPLACE_LRU && frame != _back) {
+        unlink(frame);
+        append(frame);
+    }
+}
+
+// The frame no longer holds a page
+void PageReplacer::released(int frame) {
+    if (!_resident[frame]) {
+        return;
+    }
+    _resident[frame] = false;
+    _referenced[frame] = false;
+    if (_policy != REPLACE_CLOCK) {
+        unlink(frame);
+    }
+}
+
+/*
+ * Returns the frame to evict, or -1 if no frame holds a page
+ */
+int PageReplacer::selectVictim() {
+    if (_policy != REPLACE_CLOCK) {
+        return _front;
+    }
+    // Two sweeps are enough, the first one clears every referenced bit it passes
+    int frame_count = _resident.size();
+    for (int i = 0; i < 2 * frame_count; i++) {
+        int frame = _hand;
+        _hand = (_hand + 1) % frame_count;
+        if (!_resident[frame]) {
+            continue;
+        }
+        if (_referenced[frame]) {
+            _referenced[frame] = false;
+            continue;
+        }
+        return frame;
+    }
+    return -1;
+}
@@ -1,112 +1,1037 @@
 #include "pagetable.h"
+#include "conditionallock.h"
+#include "stats.h"
 #include <algorithm>
+#include <utility>
+#include <map>
+#include <cstring>
 
-PageTable::PageTable(int page_size) {
+// Core the calling thread simulates, picks its TLB and frame cache
+thread_local int PageTable::_core = 0;
+
+PageTable::PageTable(int page_size, Tlb *tlb, int shard_count, PageTableLayout layout) {
     _page_size = page_size;
+    _layout = layout;
+    // virtual addresses are non-negative ints
+    _page_number_bits = 31;
+    for (int size = page_size; size > 1; size >>= 1) {
+        _page_number_bits--;
+    }
+    _shard_count = shard_count;
+    _concurrent = shard_count > 1;
+    _shards = new PageTableShard[shard_count];
+    _memory = NULL;
+    _swap = NULL;
+    _replacer = NULL;
+    _frame_count = 0;
+    _faults = 0;
+    _evictions = 0;
+    _large_pages = 1;
+    _shared_frames = 0;
+    _copies = 0;
+    addCore(tlb);
 }
 
 PageTable::~PageTable() {
+    clear();
+    delete[] _shards;
+    delete _replacer;
 }
 
-void PageTable::addEntry(uint32_t pid, int page_number) {
-    // Combination of pid and page number act as the key to look up frame number
-    std::string entry = std::to_string(pid) + "|" + std::to_string(page_number);
-    // If it does not exist yet
-    if(_table.count(entry) == 0){
-        // Find free frame
-        // Start at 0 and increment up until a free frame is found
-        int frame = 0;
-        sort(_frames.begin(), _frames.end()); // sort _frames from smallest to largest
-        // std::cout << "existing number of frames: " << _frames.size() << std::endl;
-        // Looks for hole in frames, if non then put at end
-        for (int i = 0; i <= _frames.size(); i++) {
-            // check if there is an empty frame in _frames
-            // if i is equal to size of _frames then all _frames were checked
-            // so use the frame that follows last frame
-            if (i == _frames.size() || frame != _frames[i]) {
-                // found free frame
+/*
+ * Registers the TLB of another simulated core, returns the core number to pass to setCore
+ * Cores have to be added before client threads start
+ */
+int PageTable::addCore(Tlb *tlb) {
+    tlb->setConcurrent(_concurrent);
+    tlb->setLargePages(_large_pages);
+    _tlbs.push_back(tlb);
+    _frame_caches.resize(_tlbs.size());
+    return _tlbs.size() - 1;
+}
+
+void PageTable::setCore(int core) {
+    _core = core;
+}
+
+// Memory frames are in, pages are copied through it for swapping and copy on write
+void PageTable::setPhysicalMemory(PhysicalMemory *memory) {
+    _memory = memory;
+}
+
+/*
+ * Bounds the frame pool to the frames in physical memory
+ * Once every frame is in use, mapping a page evicts another one to the swap file,
+ * and touching a page that was evicted faults it back in
+ * Swap is only supported with a single shard
+ */
+void PageTable::enableSwap(SwapFile *swap, ReplacementPolicy policy) {
+    _swap = swap;
+    _frame_count = _memory->getSize() / _page_size;
+    _replacer = new PageReplacer(_frame_count, policy);
+    FrameOwner unowned = {0, -1};
+    _frame_owners.resize(_frame_count, unowned);
+}
+
+PageTableShard *PageTable::getShard(uint32_t pid) {
+    return &_shards[pid % _shard_count];
+}
+
+/*
+ * Lets whole large pages of pages contiguous frames be mapped with one entry
+ * pages is a power of two, large pages are not supported with swap
+ */
+void PageTable::enableLargePages(int pages) {
+    _large_pages = pages;
+    for (int i = 0; i < _tlbs.size(); i++) {
+        _tlbs[i]->setLargePages(pages);
+    }
+}
+
+int PageTable::getLargePages() {
+    return _large_pages;
+}
+
+// Returns the process's table, or NULL if it has none, the caller holds the shard's lock
+ProcessPageTable *PageTable::getTable(PageTableShard *shard, uint32_t pid) {
+    uint32_t index = pid / _shard_count;
+    if (index >= shard->tables.size()) {
+        return NULL;
+    }
+    return shard->tables[index];
+}
+
+// Returns the process's large page table, or NULL if it has none, the caller holds the shard's lock
+std::vector<PageTableEntry> *PageTable::getLargeTable(PageTableShard *shard, uint32_t pid) {
+    uint32_t index = pid / _shard_count;
+    if (index >= shard->large_tables.size()) {
+        return NULL;
+    }
+    return &shard->large_tables[index];
+}
+
+/*
+ * Takes the lowest free frame
+ * In concurrent mode each core takes frames from its own cache, which is refilled from
+ * the shared allocator in batches so cores rarely contend for the allocator's lock
+ */
+int PageTable::allocateFrame() {
+    STAT_SCOPE(STAT_FRAME_ALLOCATE);
+    if (!_concurrent) {
+        // make room in a full pool, or fail if nothing can be evicted
+        if (_swap != NULL && _frame_allocator.getUsedCount() >= _frame_count && !evictFrame()) {
+            return -1;
+        }
+        return _frame_allocator.allocate();
+    }
+    std::vector<int> &cache = _frame_caches[_core];
+    if (cache.empty()) {
+        std::lock_guard<std::mutex> lock(_frame_lock);
+        for (int i = 0; i < 16; i++) {
+            cache.push_back(_frame_allocator.allocate());
+        }
+        // hand out the lowest of the batch first
+        std::reverse(cache.begin(), cache.end());
+    }
+    int frame = cache.back();
+    cache.pop_back();
+    return frame;
+}
+
+// Hands released frames back to physical memory, the benchmarks run page tables without one
+void PageTable::uncommitFrames(int first_frame, int count) {
+    if (_memory != NULL) {
+        _memory->release(first_frame, count);
+    }
+}
+
+void PageTable::releaseFrame(int frame) {
+    uncommitFrames(frame, 1);
+    if (!_concurrent) {
+        _frame_allocator.release(frame);
+        return;
+    }
+    std::vector<int> &cache = _frame_caches[_core];
+    cache.push_back(frame);
+    if (cache.size() > 32) {
+        std::lock_guard<std::mutex> lock(_frame_lock);
+        for (int i = 0; i < 16; i++) {
+            _frame_allocator.release(cache.back());
+            cache.pop_back();
+        }
+    }
+}
+
+// Puts a page in a frame that was just allocated for it
+void PageTable::loadFrame(uint32_t pid, PageTableEntry *entry, int page_number, int frame) {
+    entry->frame = frame;
+    if (_replacer != NULL && frame != -1) {
+        FrameOwner owner = {pid, page_number};
+        _frame_owners[frame] = owner;
+        _replacer->loaded(frame);
+    }
+}
+
+/*
+ * Writes the page in the replacement policy's victim frame to the swap file and releases the frame
+ * Returns false if there is no victim or the page could not be written
+ */
+bool PageTable::evictFrame() {
+    STAT_SCOPE(STAT_EVICTION);
+    int frame = _replacer->selectVictim();
+    if (frame == -1) {
+        return false;
+    }
+    FrameOwner owner = _frame_owners[frame];
+    int slot = _swap->writePage(_memory->access((long)frame * _page_size, _page_size, false));
+    if (slot == -1) {
+        return false;
+    }
+    PageTableEntry *entry = getTable(getShard(owner.pid), owner.pid)->getEntry(owner.page_number, false);
+    entry->frame = -1;
+    entry->swap_slot = slot;
+    _replacer->released(frame);
+    releaseFrame(frame);
+    for (int i = 0; i < _tlbs.size(); i++) {
+        _tlbs[i]->invalidate(owner.pid, owner.page_number);
+    }
+    _evictions++;
+    return true;
+}
+
+// Page fault, reads an evicted page back into a frame, the entry keeps its swap slot if that fails
+void PageTable::swapIn(uint32_t pid, PageTableEntry *entry, int page_number) {
+    STAT_SCOPE(STAT_PAGE_FAULT);
+    int frame = allocateFrame();
+    if (frame == -1) {
+        return;
+    }
+    if (!_swap->readPage(entry->swap_slot, _memory->access((long)frame * _page_size, _page_size, true))) {
+        releaseFrame(frame);
+        return;
+    }
+    _swap->release(entry->swap_slot);
+    entry->swap_slot = -1;
+    loadFrame(pid, entry, page_number, frame);
+    _faults++;
+}
+
+// Translations call this on every write, so the lock is only taken once some frame is shared
+bool PageTable::isShared(int frame) {
+    if (_shared_frames.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    ConditionalLock lock(_share_lock, _concurrent);
+    return _frame_shares.count(frame) > 0;
+}
+
+/*
+ * Adds an entry to the ones mapping a frame, the frame is pinned while it is shared
+ * pid and page_number are the entry that is added, large pages pass their large page number
+ */
+void PageTable::shareFrame(int frame, uint32_t pid, int page_number) {
+    ConditionalLock lock(_share_lock, _concurrent);
+    FrameOwner owner = {pid, page_number};
+    auto it = _frame_shares.find(frame);
+    if (it == _frame_shares.end()) {
+        _frame_shares[frame] = 2;
+        _shared_frames.store(_frame_shares.size(), std::memory_order_release);
+        if (_replacer != NULL) {
+            _replacer->released(frame);
+            std::vector<FrameOwner> &sharers = _frame_sharers[frame];
+            sharers.push_back(_frame_owners[frame]);
+            sharers.push_back(owner);
+        }
+    } else {
+        it->second++;
+        if (_replacer != NULL) {
+            _frame_sharers[frame].push_back(owner);
+        }
+    }
+}
+
+/*
+ * Drops an entry from the ones mapping a frame, returns false if it was the only one and the frame can be released
+ * Once one entry is left the frame belongs to it again and can be evicted
+ */
+bool PageTable::unshareFrame(int frame, uint32_t pid, int page_number) {
+    if (_shared_frames.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    ConditionalLock lock(_share_lock, _concurrent);
+    auto it = _frame_shares.find(frame);
+    if (it == _frame_shares.end()) {
+        return false;
+    }
+    if (_replacer != NULL) {
+        std::vector<FrameOwner> &sharers = _frame_sharers[frame];
+        for (int i = 0; i < sharers.size(); i++) {
+            if (sharers[i].pid == pid && sharers[i].page_number == page_number) {
+                sharers.erase(sharers.begin() + i);
                 break;
             }
-            // std::cout << "frame checked: " << _frames[i] << std::endl;
-            frame++;
         }
-//        std::cout << "page " << page_number << " inserted at frame: " << frame << std::endl;
-        _frames.push_back(frame); // store which frame is in use
-        _table[entry] = frame; // add frame to table
     }
+    if (--it->second <= 1) {
+        _frame_shares.erase(it);
+        _shared_frames.store(_frame_shares.size(), std::memory_order_release);
+        if (_replacer != NULL) {
+            auto sharers = _frame_sharers.find(frame);
+            if (!sharers->second.empty()) {
+                _frame_owners[frame] = sharers->second[0];
+                _replacer->loaded(frame);
+            }
+            _frame_sharers.erase(sharers);
+        }
+    }
+    return true;
 }
 
+/*
+ * Gives a page that is written to a copy of its shared frame
+ * Returns false if there is no frame to copy to, the page is left shared
+ */
+bool PageTable::copyOnWrite(uint32_t pid, PageTableEntry *entry, int page_number) {
+    int frame = allocateFrame();
+    uint8_t *destination = frame == -1 ? NULL : _memory->access((long)frame * _page_size, _page_size, true);
+    uint8_t *source = _memory->access((long)entry->frame * _page_size, _page_size, false);
+    if (destination == NULL || source == NULL) {
+        if (frame != -1) {
+            releaseFrame(frame);
+        }
+        return false;
+    }
+    std::memcpy(destination, source, _page_size);
+    unshareFrame(entry->frame, pid, page_number);
+    loadFrame(pid, entry, page_number, frame);
+    for (int i = 0; i < _tlbs.size(); i++) {
+        _tlbs[i]->invalidate(pid, page_number);
+    }
+    _copies++;
+    return true;
+}
+
+bool PageTable::copyOnWriteLarge(uint32_t pid, PageTableEntry *entry, int large_page_number) {
+    long large_page_size = (long)_large_pages * _page_size;
+    int frame;
+    {
+        ConditionalLock frame_lock(_frame_lock, _concurrent);
+        frame = _frame_allocator.allocateAligned(_large_pages);
+    }
+    uint8_t *destination = _memory->access((long)frame * _page_size, large_page_size, true);
+    uint8_t *source = _memory->access((long)entry->frame * _page_size, large_page_size, false);
+    if (destination == NULL || source == NULL) {
+        ConditionalLock frame_lock(_frame_lock, _concurrent);
+        _frame_allocator.releaseRange(frame, _large_pages);
+        uncommitFrames(frame, _large_pages);
+        return false;
+    }
+    std::memcpy(destination, source, large_page_size);
+    unshareFrame(entry->frame, pid, large_page_number);
+    entry->frame = frame;
+    for (int i = 0; i < _tlbs.size(); i++) {
+        _tlbs[i]->invalidateLarge(pid, large_page_number);
+    }
+    _copies++;
+    return true;
+}
+
+/*
+ * Adds a reference to a page, mapping it to a frame when it gets its first one
+ */
+void PageTable::addEntry(uint32_t pid, int page_number) {
+    PageTableShard *shard = getShard(pid);
+    ConditionalLock lock(shard->lock, _concurrent);
+
+    // Grow the table list so the pid can be indexed directly, and give the process a table on its first page
+    uint32_t index = pid / _shard_count;
+    if (index >= shard->tables.size()) {
+        shard->tables.resize(index + 1, NULL);
+    }
+    if (shard->tables[index] == NULL) {
+        shard->tables[index] = new ProcessPageTable(_layout, _page_number_bits);
+    }
+    PageTableEntry *entry = shard->tables[index]->getEntry(page_number, true);
+    if (entry == NULL) {
+        return;
+    }
+    // If it does not exist yet
+    if(entry->frame == -1 && entry->swap_slot == -1){
+        loadFrame(pid, entry, page_number, allocateFrame());
+    }
+    entry->references++;
+}
+
+/*
+ * Drops a reference to a page, unmapping it and releasing its frame when no variables are left on it
+ */
 void PageTable::removeEntry(uint32_t pid, int page_number) {
-    std::string entry = std::to_string(pid) + "|" + std::to_string(page_number);
+    PageTableShard *shard = getShard(pid);
+    ConditionalLock lock(shard->lock, _concurrent);
+
+    ProcessPageTable *table = getTable(shard, pid);
+    PageTableEntry *entry = table == NULL ? NULL : table->getEntry(page_number, false);
     // if entry exists
-    if(_table.count(entry) > 0){
-        int frame = _table[entry];
-        // remove entry
-        _table.erase(entry);
-        // remove frame
-        for(int i = 0; i < _frames.size(); i++){
-            if(_frames[i] == frame){
-                _frames.erase(_frames.begin() + i);
-                break;
+    if (entry != NULL && entry->references > 0) {
+        entry->references--;
+        if (entry->references <= 0) {
+            unmapPage(pid, entry, page_number);
+        }
+    }
+}
+
+/*
+ * Maps a large page to a run of contiguous frames aligned to its size
+ * Large pages only ever hold bytes of one variable, so they have a single reference
+ */
+void PageTable::addLargeEntry(uint32_t pid, int large_page_number) {
+    PageTableShard *shard = getShard(pid);
+    ConditionalLock lock(shard->lock, _concurrent);
+
+    uint32_t index = pid / _shard_count;
+    if (index >= shard->large_tables.size()) {
+        shard->large_tables.resize(index + 1);
+    }
+    std::vector<PageTableEntry> &table = shard->large_tables[index];
+    if (large_page_number >= table.size()) {
+        PageTableEntry unmapped = {-1, 0, -1, false};
+        table.resize(large_page_number + 1, unmapped);
+    }
+    if (table[large_page_number].frame == -1) {
+        ConditionalLock frame_lock(_frame_lock, _concurrent);
+        table[large_page_number].frame = _frame_allocator.allocateAligned(_large_pages);
+    }
+    table[large_page_number].references++;
+}
+
+void PageTable::removeLargeEntry(uint32_t pid, int large_page_number) {
+    PageTableShard *shard = getShard(pid);
+    ConditionalLock lock(shard->lock, _concurrent);
+
+    std::vector<PageTableEntry> *table = getLargeTable(shard, pid);
+    if (table == NULL || large_page_number < 0 || large_page_number >= table->size() ||
+            (*table)[large_page_number].references <= 0) {
+        return;
+    }
+    PageTableEntry *entry = &(*table)[large_page_number];
+    entry->references--;
+    if (entry->references <= 0) {
+        // frames shared with a forked process stay with it
+        if (!unshareFrame(entry->frame, pid, large_page_number)) {
+            ConditionalLock frame_lock(_frame_lock, _concurrent);
+            _frame_allocator.releaseRange(entry->frame, _large_pages);
+            uncommitFrames(entry->frame, _large_pages);
+        }
+        entry->frame = -1;
+        entry->references = 0;
+        for (int i = 0; i < _tlbs.size(); i++) {
+            _tlbs[i]->invalidateLarge(pid, large_page_number);
+        }
+    }
+}
+
+// Releases a page's frame or swap slot and drops it from every core's TLB, the caller holds the shard's lock
+void PageTable::unmapPage(uint32_t pid, PageTableEntry *entry, int page_number) {
+    if (entry->frame != -1) {
+        // release frame, unless it is shared with a forked process
+        if (!unshareFrame(entry->frame, pid, page_number)) {
+            if (_replacer != NULL) {
+                _replacer->released(entry->frame);
             }
+            releaseFrame(entry->frame);
+        }
+        for (int i = 0; i < _tlbs.size(); i++) {
+            _tlbs[i]->invalidate(pid, page_number);
         }
     }
+    if (entry->swap_slot != -1) {
+        _swap->release(entry->swap_slot);
+    }
+    // remove entry
+    entry->frame = -1;
+    entry->swap_slot = -1;
+    entry->references = 0;
+    entry->shared = false;
 }
 
 void PageTable::removeProcess(uint32_t pid) {
-    for(int i = 0; i < _frames.size(); i++){
-        removeEntry(pid, i);
+    PageTableShard *shard = getShard(pid);
+    ConditionalLock lock(shard->lock, _concurrent);
+
+    ProcessPageTable *table = getTable(shard, pid);
+    std::vector<PageTableEntry> *large_table = getLargeTable(shard, pid);
+    if (table == NULL && large_table == NULL) {
+        return;
+    }
+    if (table != NULL) {
+        table->forEachEntry([this, pid](int page, PageTableEntry *entry) {
+            if (entry->frame != -1 && !unshareFrame(entry->frame, pid, page)) {
+                if (_replacer != NULL) {
+                    _replacer->released(entry->frame);
+                }
+                releaseFrame(entry->frame);
+            }
+            if (entry->swap_slot != -1) {
+                _swap->release(entry->swap_slot);
+            }
+        });
+        // release the process's table
+        delete table;
+        shard->tables[pid / _shard_count] = NULL;
+    }
+    if (large_table != NULL) {
+        ConditionalLock frame_lock(_frame_lock, _concurrent);
+        for (int large_page = 0; large_page < large_table->size(); large_page++) {
+            if ((*large_table)[large_page].frame != -1 &&
+                    !unshareFrame((*large_table)[large_page].frame, pid, large_page)) {
+                _frame_allocator.releaseRange((*large_table)[large_page].frame, _large_pages);
+                uncommitFrames((*large_table)[large_page].frame, _large_pages);
+            }
+        }
+        std::vector<PageTableEntry>().swap(*large_table);
+    }
+    for (int i = 0; i < _tlbs.size(); i++) {
+        _tlbs[i]->invalidateProcess(pid);
     }
 }
 
-int PageTable::getPhysicalAddress(uint32_t pid, int virtual_address) {
+/*
+ * Maps every page of a forked process to the same frame as its parent's page
+ * The frames become shared and are copied when either process writes to them,
+ * evicted pages get their own copy in the swap file
+ */
+void PageTable::forkProcess(uint32_t parent_pid, uint32_t child_pid) {
+    std::vector<std::pair<int, PageTableEntry> > entries;
+    std::vector<PageTableEntry> large_entries;
+    {
+        PageTableShard *shard = getShard(parent_pid);
+        ConditionalLock lock(shard->lock, _concurrent);
+        ProcessPageTable *table = getTable(shard, parent_pid);
+        if (table != NULL) {
+            table->forEachEntry([&entries](int page, PageTableEntry *entry) {
+                if (entry->references > 0) {
+                    entries.push_back(std::make_pair(page, *entry));
+                }
+            });
+        }
+        std::vector<PageTableEntry> *large_table = getLargeTable(shard, parent_pid);
+        if (large_table != NULL) {
+            large_entries = *large_table;
+        }
+    }
+
+    for (int i = 0; i < entries.size(); i++) {
+        PageTableEntry *entry = &entries[i].second;
+        if (entry->frame != -1) {
+            shareFrame(entry->frame, child_pid, entries[i].first);
+        } else if (entry->swap_slot != -1) {
+            entry->swap_slot = _swap->copyPage(entry->swap_slot);
+        }
+    }
+    for (int i = 0; i < large_entries.size(); i++) {
+        if (large_entries[i].frame != -1) {
+            shareFrame(large_entries[i].frame, child_pid, i);
+        }
+    }
+
+    PageTableShard *shard = getShard(child_pid);
+    ConditionalLock lock(shard->lock, _concurrent);
+    uint32_t index = child_pid / _shard_count;
+    if (index >= shard->tables.size()) {
+        shard->tables.resize(index + 1, NULL);
+    }
+    if (shard->tables[index] == NULL) {
+        shard->tables[index] = new ProcessPageTable(_layout, _page_number_bits);
+    }
+    for (int i = 0; i < entries.size(); i++) {
+        *shard->tables[index]->getEntry(entries[i].first, true) = entries[i].second;
+    }
+    if (!large_entries.empty()) {
+        if (index >= shard->large_tables.size()) {
+            shard->large_tables.resize(index + 1);
+        }
+        shard->large_tables[index] = large_entries;
+    }
+}
+
+/*
+ * Maps a run of pages of one process into another, both entries then point at the same frames
+ * Frames of a shared segment are written in place, and released when the last entry mapping them is removed
+ * Returns false if a page is not mapped or has no frame, the pages before it are mapped in the target
+ */
+bool PageTable::sharePages(uint32_t pid, int first_page_number, uint32_t target_pid, int target_first_page_number,
+                           int count) {
+    std::vector<int> frames;
+    {
+        PageTableShard *shard = getShard(pid);
+        ConditionalLock lock(shard->lock, _concurrent);
+        ProcessPageTable *table = getTable(shard, pid);
+        for (int i = 0; i < count; i++) {
+            int page_number = first_page_number + i;
+            PageTableEntry *entry = table == NULL ? NULL : table->getEntry(page_number, false);
+            if (entry == NULL || entry->references <= 0) {
+                break;
+            }
+            if (entry->frame == -1 && entry->swap_slot != -1) {
+                swapIn(pid, entry, page_number);
+            }
+            // a frame still shared copy-on-write with a forked process gets a copy of its own first
+            if (entry->frame != -1 && !entry->shared && isShared(entry->frame) &&
+                    !copyOnWrite(pid, entry, page_number)) {
+                break;
+            }
+            if (entry->frame == -1) {
+                break;
+            }
+            shareFrame(entry->frame, target_pid, target_first_page_number + frames.size());
+            entry->shared = true;
+            frames.push_back(entry->frame);
+        }
+    }
+
+    PageTableShard *shard = getShard(target_pid);
+    ConditionalLock lock(shard->lock, _concurrent);
+    uint32_t index = target_pid / _shard_count;
+    if (index >= shard->tables.size()) {
+        shard->tables.resize(index + 1, NULL);
+    }
+    if (shard->tables[index] == NULL) {
+        shard->tables[index] = new ProcessPageTable(_layout, _page_number_bits);
+    }
+    for (int i = 0; i < frames.size(); i++) {
+        PageTableEntry *entry = shard->tables[index]->getEntry(target_first_page_number + i, true);
+        if (entry == NULL || entry->references > 0) {
+            // the target pages must not be mapped yet
+            for (int j = i; j < frames.size(); j++) {
+                unshareFrame(frames[j], target_pid, target_first_page_number + j);
+            }
+            return false;
+        }
+        entry->frame = frames[i];
+        entry->swap_slot = -1;
+        entry->references = 1;
+        entry->shared = true;
+    }
+    return frames.size() == count;
+}
+
+long PageTable::getPhysicalAddress(uint32_t pid, int virtual_address, bool write) {
+    STAT_SCOPE(STAT_TRANSLATE);
     // Convert virtual address to page_number and page_offset
 
     int page_number = virtual_address / _page_size; // 11 / 5 = 2
     int page_offset = virtual_address % _page_size; // left over is offset = 1
 
-    // Combination of pid and page number act as the key to look up frame number
-    std::string entry = std::to_string(pid) + "|" + std::to_string(page_number);
-
     // If entry exists, look up frame number and convert virtual to physical address
-    int address = -1;
-    if (_table.count(entry) > 0) {
-        int frame = _table[entry];
-        address = (frame * _page_size) + page_offset;
+    // Check this core's TLB first and only walk the table on a miss
+    Tlb *tlb = _tlbs[_core];
+    long address = -1;
+    int frame;
+    bool hit = tlb->lookup(pid, page_number, &frame);
+    // writes to shared frames take the walk below, which copies them
+    if (hit && write && (isShared(frame) || isShared(frame - frame % _large_pages))) {
+        hit = false;
+    }
+    if (hit) {
+        if (_replacer != NULL) {
+            _replacer->accessed(frame);
+        }
+        address = ((long)frame * _page_size) + page_offset;
+    } else if (virtual_address >= 0) {
+        // only the process's own shard is locked
+        PageTableShard *shard = getShard(pid);
+        ConditionalLock lock(shard->lock, _concurrent);
+        ProcessPageTable *table = getTable(shard, pid);
+        PageTableEntry *entry = table == NULL ? NULL : table->getEntry(page_number, false);
+        std::vector<PageTableEntry> *large_table;
+        int large_page_number = page_number / _large_pages;
+        if (entry != NULL) {
+            if (entry->frame == -1 && entry->swap_slot != -1) {
+                swapIn(pid, entry, page_number);
+            }
+            if (write && entry->frame != -1 && !entry->shared && isShared(entry->frame) &&
+                    !copyOnWrite(pid, entry, page_number)) {
+                return -1;
+            }
+            frame = entry->frame;
+            if (frame != -1) {
+                if (_replacer != NULL) {
+                    _replacer->accessed(frame);
+                }
+                tlb->insert(pid, page_number, frame);
+                address = ((long)frame * _page_size) + page_offset;
+            }
+        }
+        // pages that are not mapped on their own may be part of a large page
+        if (address == -1 && _large_pages > 1 && (large_table = getLargeTable(shard, pid)) != NULL &&
+                large_page_number < large_table->size() && (*large_table)[large_page_number].frame != -1) {
+            PageTableEntry *large_entry = &(*large_table)[large_page_number];
+            if (write && isShared(large_entry->frame) && !copyOnWriteLarge(pid, large_entry, large_page_number)) {
+                return -1;
+            }
+            frame = large_entry->frame;
+            tlb->insertLarge(pid, large_page_number, frame);
+            address = ((long)(frame + page_number % _large_pages) * _page_size) + page_offset;
+        }
     }
 
     return address;
 }
 
-void PageTable::print() {
-    std::map<std::string, int>::iterator it;
+int PageTable::getPageSize() {
+    return _page_size;
+}
+
+// Pages read back from the swap file
+long PageTable::getFaultCount() {
+    return _faults;
+}
 
-    std::cout << " PID  | Page Number | Frame Number" << std::endl;
-    std::cout << "------+-------------+--------------" << std::endl;
+long PageTable::getEvictionCount() {
+    return _evictions;
+}
+
+void PageTable::print() {
+    // Entries are listed in the order of their "pid|page_number" text, which
+    // is the order this table has always been printed in
+    // Large pages are listed by the range of pages and frames they cover
+    std::vector<std::pair<std::string, std::string> > entries;
+    for (int i = 0; i < _shard_count; i++) {
+        PageTableShard *shard = &_shards[i];
+        ConditionalLock lock(shard->lock, _concurrent);
+        for (uint32_t index = 0; index < shard->tables.size(); index++) {
+            if (shard->tables[index] == NULL) {
+                continue;
+            }
+            std::string pid = std::to_string(index * _shard_count + i);
+            shard->tables[index]->forEachEntry([&entries, &pid](int page, PageTableEntry *entry) {
+                if (entry->frame != -1) {
+                    entries.push_back(std::make_pair(pid + "|" + std::to_string(page),
+                                                     std::to_string(entry->frame)));
+                } else if (entry->swap_slot != -1) {
+                    // evicted
+                    entries.push_back(std::make_pair(pid + "|" + std::to_string(page),
+                                                     "swap " + std::to_string(entry->swap_slot)));
+                }
+            });
+        }
+        for (uint32_t index = 0; index < shard->large_tables.size(); index++) {
+            uint32_t pid = index * _shard_count + i;
+            std::vector<PageTableEntry> &table = shard->large_tables[index];
+            for (int large_page = 0; large_page < table.size(); large_page++) {
+                if (table[large_page].frame != -1) {
+                    int first_page = large_page * _large_pages;
+                    int first_frame = table[large_page].frame;
+                    entries.push_back(std::make_pair(
+                            std::to_string(pid) + "|" + std::to_string(first_page) + "-" +
+                            std::to_string(first_page + _large_pages - 1),
+                            std::to_string(first_frame) + "-" + std::to_string(first_frame + _large_pages - 1)));
+                }
+            }
+        }
+    }
+    sort(entries.begin(), entries.end());
 
-    for (it = _table.begin(); it != _table.end(); it++) {
-        // TODO: this needs to be split
-        // key
-        std::string key = it->first;
-        // value
-        int frame = it->second;
+    std::cout << " PID  | Page Number | Frame Number" << '\n';
+    std::cout << "------+-------------+--------------" << '\n';
 
-        std::string pid;
-        std::string page_number;
-        splitEntry(&key, &pid, &page_number);
+    for (int i = 0; i < entries.size(); i++) {
+        std::string::size_type pos = entries[i].first.find('|');
+        std::string pid = entries[i].first.substr(0, pos);
+        std::string page_number = entries[i].first.substr(pos + 1);
 
         std::cout << " " << pid << " | ";
         std::cout << std::setw(11) << std::right << page_number << " | ";
-        std::cout << std::setw(12) << std::right << frame << std::endl;
+        std::cout << std::setw(12) << std::right << entries[i].second << '\n';
+    }
+}
+
+/*
+ * Print the frame pool, page faults and evictions, and swap file I/O
+ * initiated by command 'print swap'
+ */
+void PageTable::printSwap() {
+    if (_swap == NULL) {
+        std::cout << "Swap is not enabled." << '\n';
+        return;
+    }
+    const char *policy_names[] = {"FIFO", "LRU", "CLOCK"};
+    std::cout << "Frames:    " << _frame_allocator.getUsedCount() << " of " << _frame_count << " in use ("
+              << policy_names[_replacer->getPolicy()] << " replacement)" << '\n';
+    std::cout << "Faults:    " << _faults << '\n';
+    std::cout << "Evictions: " << _evictions << '\n';
+    _swap->print();
+}
+
+/*
+ * Print how many page table entries each process uses, and how many it would need without large pages
+ * initiated by command 'print ptes'
+ */
+void PageTable::printPtes() {
+    // pid -> base entries, large entries
+    std::map<uint32_t, std::pair<long, long> > counts;
+    for (int i = 0; i < _shard_count; i++) {
+        PageTableShard *shard = &_shards[i];
+        ConditionalLock lock(shard->lock, _concurrent);
+        for (uint32_t index = 0; index < shard->tables.size(); index++) {
+            if (shard->tables[index] == NULL) {
+                continue;
+            }
+            long *base = &counts[index * _shard_count + i].first;
+            shard->tables[index]->forEachEntry([base](int, PageTableEntry *entry) {
+                if (entry->frame != -1 || entry->swap_slot != -1) {
+                    (*base)++;
+                }
+            });
+        }
+        for (uint32_t index = 0; index < shard->large_tables.size(); index++) {
+            std::vector<PageTableEntry> &table = shard->large_tables[index];
+            for (int large_page = 0; large_page < table.size(); large_page++) {
+                if (table[large_page].frame != -1) {
+                    counts[index * _shard_count + i].second++;
+                }
+            }
+        }
+    }
+
+    std::cout << "Large pages: " << (_large_pages > 1 ? std::to_string((long)_large_pages * _page_size) + " bytes"
+                                                       : std::string("off")) << '\n';
+    std::cout << " PID  |  Base PTEs  |  Large PTEs  | Without Large |  Saved" << '\n';
+    std::cout << "------+-------------+--------------+---------------+---------" << '\n';
+    long total_entries = 0;
+    long total_without_large = 0;
+    for (auto it = counts.begin(); it != counts.end(); ++it) {
+        long base = it->second.first;
+        long large = it->second.second;
+        if (base + large == 0) {
+            continue;
+        }
+        long without_large = base + large * _large_pages;
+        total_entries += base + large;
+        total_without_large += without_large;
+        std::cout << " " << it->first << " | ";
+        std::cout << std::setw(11) << std::right << base << " | ";
+        std::cout << std::setw(12) << std::right << large << " | ";
+        std::cout << std::setw(13) << std::right << without_large << " | ";
+        std::cout << std::setw(7) << std::right << without_large - base - large << '\n';
+    }
+    std::cout << "Total: " << total_entries << " entries, " << total_without_large << " without large pages, "
+              << total_without_large - total_entries << " saved" << '\n';
+    std::cout << "Shared frames: " << _frame_shares.size() << ", " << _copies << " copied on write" << '\n';
+}
+
+/*
+ * Print the bytes spent on each process's page table structures
+ * initiated by command 'print ptmem'
+ */
+void PageTable::printMemory() {
+    // pid -> table bytes, large table bytes
+    std::map<uint32_t, std::pair<long, long> > bytes;
+    for (int i = 0; i < _shard_count; i++) {
+        PageTableShard *shard = &_shards[i];
+        ConditionalLock lock(shard->lock, _concurrent);
+        for (uint32_t index = 0; index < shard->tables.size(); index++) {
+            if (shard->tables[index] != NULL) {
+                bytes[index * _shard_count + i].first = shard->tables[index]->getMemoryBytes();
+            }
+        }
+        for (uint32_t index = 0; index < shard->large_tables.size(); index++) {
+            if (shard->large_tables[index].capacity() > 0) {
+                bytes[index * _shard_count + i].second =
+                        shard->large_tables[index].capacity() * sizeof(PageTableEntry);
+            }
+        }
+    }
 
+    const char *layout_names[] = {"flat", "two-level radix", "three-level radix"};
+    std::cout << "Page table: " << layout_names[_layout] << ", " << sizeof(PageTableEntry) << " byte entries" << '\n';
+    std::cout << " PID  |  Table Bytes  | Large Table Bytes |  Total Bytes" << '\n';
+    std::cout << "------+---------------+-------------------+---------------" << '\n';
+    long total = 0;
+    for (auto it = bytes.begin(); it != bytes.end(); ++it) {
+        long table_bytes = it->second.first;
+        long large_table_bytes = it->second.second;
+        total += table_bytes + large_table_bytes;
+        std::cout << " " << it->first << " | ";
+        std::cout << std::setw(13) << std::right << table_bytes << " | ";
+        std::cout << std::setw(17) << std::right << large_table_bytes << " | ";
+        std::cout << std::setw(13) << std::right << table_bytes + large_table_bytes << '\n';
     }
+    std::cout << "Total: " << total << " bytes" << '\n';
 }
 
-void PageTable::splitEntry(std::string *entry, std::string *pid, std::string *page_number) {
-    std::string::size_type pos;
-    pos = entry->find('|', 0);
-    if (pos != std::string::npos) {
-        *pid = entry->substr(0, pos);
-        *page_number = entry->substr(pos + 1);
+// Unmaps every page of every process and releases every frame
+void PageTable::clear() {
+    for (int i = 0; i < _shard_count; i++) {
+        for (int j = 0; j < _shards[i].tables.size(); j++) {
+            delete _shards[i].tables[j];
+        }
+        _shards[i].tables.clear();
+        _shards[i].large_tables.clear();
+    }
+    for (int i = 0; i < _frame_caches.size(); i++) {
+        _frame_caches[i].clear();
+    }
+    _frame_allocator.clear();
+    _frame_shares.clear();
+    _frame_sharers.clear();
+    _shared_frames = 0;
+    for (int i = 0; i < _tlbs.size(); i++) {
+        _tlbs[i]->flush();
+    }
+}
+
+/*
+ * Writes the frame allocator, the shared frames and every process's mapped entries
+ * Checkpoints do not hold a swap file, so they can only be taken without one
+ */
+bool PageTable::save(CheckpointWriter *writer, std::string *error) {
+    if (_swap != NULL) {
+        *error = "checkpoints can not be taken with a swap file";
+        return false;
+    }
+    writer->write<int64_t>(_faults);
+    writer->write<int64_t>(_evictions);
+    writer->write<int64_t>(_copies);
+    _frame_allocator.save(writer);
+    writer->write<uint32_t>(_frame_shares.size());
+    for (auto it = _frame_shares.begin(); it != _frame_shares.end(); ++it) {
+        writer->write<int32_t>(it->first);
+        writer->write<int32_t>(it->second);
+    }
+
+    std::vector<std::pair<int, PageTableEntry> > entries;
+    std::vector<uint32_t> pids;
+    for (int i = 0; i < _shard_count; i++) {
+        for (uint32_t index = 0; index < _shards[i].tables.size(); index++) {
+            if (_shards[i].tables[index] != NULL) {
+                pids.push_back(index * _shard_count + i);
+            }
+        }
+    }
+    writer->write<uint32_t>(pids.size());
+    for (int i = 0; i < pids.size(); i++) {
+        entries.clear();
+        getTable(getShard(pids[i]), pids[i])->forEachEntry([&entries](int page, PageTableEntry *entry) {
+            if (entry->references > 0) {
+                entries.push_back(std::make_pair(page, *entry));
+            }
+        });
+        writer->write<uint32_t>(pids[i]);
+        writer->write<uint32_t>(entries.size());
+        for (int j = 0; j < entries.size(); j++) {
+            writer->write<int32_t>(entries[j].first);
+            writer->write<int32_t>(entries[j].second.frame);
+            writer->write<int32_t>(entries[j].second.references);
+            writer->write<uint8_t>(entries[j].second.shared);
+        }
+    }
+
+    pids.clear();
+    for (int i = 0; i < _shard_count; i++) {
+        for (uint32_t index = 0; index < _shards[i].large_tables.size(); index++) {
+            if (!_shards[i].large_tables[index].empty()) {
+                pids.push_back(index * _shard_count + i);
+            }
+        }
+    }
+    writer->write<uint32_t>(pids.size());
+    for (int i = 0; i < pids.size(); i++) {
+        std::vector<PageTableEntry> *large_table = getLargeTable(getShard(pids[i]), pids[i]);
+        writer->write<uint32_t>(pids[i]);
+        writer->write<uint32_t>(large_table->size());
+        for (int large_page = 0; large_page < large_table->size(); large_page++) {
+            writer->write<int32_t>((*large_table)[large_page].frame);
+            writer->write<int32_t>((*large_table)[large_page].references);
+        }
+    }
+    return true;
+}
+
+// Replaces every mapping with the ones in a checkpoint, returns false if it is cut short
+bool PageTable::load(CheckpointReader *reader, std::string *error) {
+    if (_swap != NULL) {
+        *error = "checkpoints can not be loaded with a swap file";
+        return false;
+    }
+    clear();
+    int64_t faults;
+    int64_t evictions;
+    int64_t copies;
+    uint32_t count;
+    if (!reader->read(&faults) || !reader->read(&evictions) || !reader->read(&copies) ||
+            !_frame_allocator.load(reader) || !reader->read(&count)) {
+        return false;
+    }
+    _faults = faults;
+    _evictions = evictions;
+    _copies = copies;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t frame;
+        int32_t shares;
+        if (!reader->read(&frame) || !reader->read(&shares)) {
+            return false;
+        }
+        _frame_shares[frame] = shares;
+    }
+    _shared_frames = _frame_shares.size();
+
+    if (!reader->read(&count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t pid;
+        uint32_t entries;
+        if (!reader->read(&pid) || !reader->read(&entries)) {
+            return false;
+        }
+        PageTableShard *shard = getShard(pid);
+        uint32_t index = pid / _shard_count;
+        if (index >= shard->tables.size()) {
+            shard->tables.resize(index + 1, NULL);
+        }
+        if (shard->tables[index] == NULL) {
+            shard->tables[index] = new ProcessPageTable(_layout, _page_number_bits);
+        }
+        for (uint32_t j = 0; j < entries; j++) {
+            int32_t page_number;
+            PageTableEntry loaded = {-1, 0, -1, false};
+            uint8_t shared;
+            if (!reader->read(&page_number) || !reader->read(&loaded.frame) || !reader->read(&loaded.references) ||
+                    !reader->read(&shared)) {
+                return false;
+            }
+            loaded.shared = shared != 0;
+            PageTableEntry *entry = shard->tables[index]->getEntry(page_number, true);
+            if (entry == NULL) {
+                return false;
+            }
+            *entry = loaded;
+        }
+    }
+
+    if (!reader->read(&count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t pid;
+        uint32_t size;
+        if (!reader->read(&pid) || !reader->read(&size)) {
+            return false;
+        }
+        PageTableShard *shard = getShard(pid);
+        uint32_t index = pid / _shard_count;
+        if (index >= shard->large_tables.size()) {
+            shard->large_tables.resize(index + 1);
+        }
+        std::vector<PageTableEntry> &table = shard->large_tables[index];
+        for (uint32_t large_page = 0; large_page < size; large_page++) {
+            PageTableEntry loaded = {-1, 0, -1, false};
+            if (!reader->read(&loaded.frame) || !reader->read(&loaded.references)) {
+                return false;
+            }
+            table.push_back(loaded);
+        }
     }
+    return true;
 }
@@ -0,0 +1,141 @@
+#include "physicalmemory.h"
+#include <algorithm>
+#include <sys/mman.h>
+#include <unistd.h>
+
+PhysicalMemory::PhysicalMemory(long size, int frame_size) {
+    _size = size;
+    _frame_size = frame_size;
+    _committed_frames = 0;
+    _committed.resize((size / frame_size + 63) / 64, 0);
+
+    // Reserve address space only, pages are zero-filled by the OS on first touch
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    _memory = memory == MAP_FAILED ? NULL : (uint8_t *)memory;
+}
+
+PhysicalMemory::~PhysicalMemory() {
+    if (_memory != NULL) {
+        munmap(_memory, _size);
+    }
+}
+
+bool PhysicalMemory::isReserved() {
+    return _memory != NULL;
+}
+
+long PhysicalMemory::getSize() {
+    return _size;
+}
+
+/*
+ * Returns a pointer to length bytes at a physical address, or NULL if they run past the end of memory
+ * Writing commits the frames the bytes are in
+ */
+uint8_t *PhysicalMemory::access(long physical_address, long length, bool write) {
+    if (physical_address < 0 || length < 0 || physical_address + length > _size) {
+        return NULL;
+    }
+    if (write && length > 0) {
+        long last_frame = (physical_address + length - 1) / _frame_size;
+        for (long frame = physical_address / _frame_size; frame <= last_frame; frame++) {
+            uint64_t bit = 1ULL << (frame % 64);
+            if (!(__atomic_load_n(&_committed[frame / 64], __ATOMIC_RELAXED) & bit) &&
+                    !(__atomic_fetch_or(&_committed[frame / 64], bit, __ATOMIC_RELAXED) & bit)) {
+                _committed_frames++;
+            }
+        }
+    }
+    return &_memory[physical_address];
+}
+
+/*
+ * Marks frames that are no longer mapped as not written
+ * Host pages that lie entirely inside them are given back to the OS, which zero-fills them
+ * if they are touched again. Smaller frames keep their host page and their old bytes.
+ */
+void PhysicalMemory::release(long first_frame, long count) {
+    long frames = _size / _frame_size;
+    if (first_frame < 0 || first_frame >= frames) {
+        return;
+    }
+    count = std::min(count, frames - first_frame);
+    for (long frame = first_frame; frame < first_frame + count; frame++) {
+        uint64_t bit = 1ULL << (frame % 64);
+        if ((__atomic_load_n(&_committed[frame / 64], __ATOMIC_RELAXED) & bit) &&
+                (__atomic_fetch_and(&_committed[frame / 64], ~bit, __ATOMIC_RELAXED) & bit)) {
+            _committed_frames--;
+        }
+    }
+    long host_page_size = sysconf(_SC_PAGESIZE);
+    long start = (first_frame * _frame_size + host_page_size - 1) / host_page_size * host_page_size;
+    long end = (first_frame + count) * _frame_size / host_page_size * host_page_size;
+    if (end > start) {
+        madvise(_memory + start, end - start, MADV_DONTNEED);
+    }
+}
+
+// Writes which frames have been written, their contents go in the frame image
+void PhysicalMemory::save(CheckpointWriter *writer) {
+    writer->write<uint32_t>(_committed.size());
+    writer->writeBytes(_committed.data(), _committed.size() * sizeof(uint64_t));
+}
+
+// Writes every frame that has been written to its place in the frame image, the rest are left as holes
+bool PhysicalMemory::writeImage(int fd, long offset) {
+    long frames = _size / _frame_size;
+    for (long frame = 0; frame < frames; frame++) {
+        if (!((_committed[frame / 64] >> (frame % 64)) & 1)) {
+            continue;
+        }
+        // write runs of committed frames with one call
+        long last = frame;
+        while (last + 1 < frames && ((_committed[(last + 1) / 64] >> ((last + 1) % 64)) & 1)) {
+            last++;
+        }
+        long start = frame * _frame_size;
+        long length = (last - frame + 1) * _frame_size;
+        for (long written = 0; written < length;) {
+            ssize_t bytes = pwrite(fd, _memory + start + written, length - written, offset + start + written);
+            if (bytes <= 0) {
+                return false;
+            }
+            written += bytes;
+        }
+        frame = last;
+    }
+    return true;
+}
+
+bool PhysicalMemory::load(CheckpointReader *reader) {
+    uint32_t words;
+    if (!reader->read(&words) || words != _committed.size() ||
+            !reader->readBytes(_committed.data(), words * sizeof(uint64_t))) {
+        return false;
+    }
+    long committed = 0;
+    for (uint32_t word = 0; word < words; word++) {
+        committed += __builtin_popcountll(_committed[word]);
+    }
+    _committed_frames = committed;
+    return true;
+}
+
+/*
+ * Replaces the whole memory with a private mapping of a frame image
+ * Frames are read from the file the first time they are touched, and writes to them are not written back
+ */
+bool PhysicalMemory::mapImage(int fd, long offset) {
+    void *memory = mmap(_memory, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, offset);
+    return memory != MAP_FAILED;
+}
+
+/*
+ * Print reserved and committed bytes
+ * initiated by command 'print memory'
+ */
+void PhysicalMemory::print() {
+    long committed = _committed_frames * _frame_size;
+    std::cout << "Reserved:  " << _size << " bytes (" << _size / _frame_size << " frames)" << '\n';
+    std::cout << "Committed: " << committed << " bytes (" << _committed_frames << " frames)" << '\n';
+}
@@ -0,0 +1,104 @@
+#include "processpagetable.h"
+
+/*
+ * page_number_bits is how many bits a page number can have, they are split
+ * as evenly as possible between the levels with any left over going to the top
+ */
+ProcessPageTable::ProcessPageTable(PageTableLayout layout, int page_number_bits) {
+    _layout = layout;
+    _levels = layout == PAGE_TABLE_THREE_LEVEL ? 3 : 2;
+    _root = NULL;
+    _radix_bytes = 0;
+    if (layout != PAGE_TABLE_FLAT) {
+        for (int i = 0; i < _levels; i++) {
+            _bits[i] = page_number_bits / _levels;
+        }
+        _bits[0] += page_number_bits % _levels;
+        _root = allocateDirectory(0);
+    }
+}
+
+ProcessPageTable::~ProcessPageTable() {
+    if (_root != NULL) {
+        freeDirectory(_root, 0);
+    }
+}
+
+// Allocates an empty directory, or an unmapped leaf table at the last level
+void **ProcessPageTable::allocateDirectory(int level) {
+    int count = 1 << _bits[level];
+    if (level == _levels - 1) {
+        PageTableEntry unmapped = {-1, 0, -1, false};
+        PageTableEntry *table = new PageTableEntry[count];
+        for (int i = 0; i < count; i++) {
+            table[i] = unmapped;
+        }
+        _radix_bytes += count * sizeof(PageTableEntry);
+        return (void **)table;
+    }
+    _radix_bytes += count * sizeof(void *);
+    return new void *[count]();
+}
+
+void ProcessPageTable::freeDirectory(void **directory, int level) {
+    if (level == _levels - 1) {
+        delete[] (PageTableEntry *)directory;
+        return;
+    }
+    for (int i = 0; i < (1 << _bits[level]); i++) {
+        if (directory[i] != NULL) {
+            freeDirectory((void **)directory[i], level + 1);
+        }
+    }
+    delete[] directory;
+}
+
+/*
+ * Returns a page's entry, or NULL if it has none and create is false
+ * With create, the table grows or the directories on the way are allocated
+ */
+PageTableEntry *ProcessPageTable::getEntry(int page_number, bool create) {
+    if (page_number < 0) {
+        return NULL;
+    }
+    if (_layout == PAGE_TABLE_FLAT) {
+        if (page_number >= _entries.size()) {
+            if (!create) {
+                return NULL;
+            }
+            PageTableEntry unmapped = {-1, 0, -1, false};
+            _entries.resize(page_number + 1, unmapped);
+        }
+        return &_entries[page_number];
+    }
+
+    // Walk down the directories, the shift is the number of page number bits below each level
+    int shift = 0;
+    for (int i = 1; i < _levels; i++) {
+        shift += _bits[i];
+    }
+    if ((page_number >> shift) >= (1 << _bits[0])) {
+        return NULL;
+    }
+    void **directory = _root;
+    for (int level = 0; level < _levels - 1; level++) {
+        int index = (page_number >> shift) & ((1 << _bits[level]) - 1);
+        if (directory[index] == NULL) {
+            if (!create) {
+                return NULL;
+            }
+            directory[index] = allocateDirectory(level + 1);
+        }
+        directory = (void **)directory[index];
+        shift -= _bits[level + 1];
+    }
+    return &((PageTableEntry *)directory)[page_number & ((1 << _bits[_levels - 1]) - 1)];
+}
+
+// Bytes spent on entries and directories
+long ProcessPageTable::getMemoryBytes() {
+    if (_layout == PAGE_TABLE_FLAT) {
+        return _entries.capacity() * sizeof(PageTableEntry);
+    }
+    return _radix_bytes;
+}
@@ -0,0 +1,210 @@
+#include "replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+const char trace_magic[8] = {'M', 'E', 'M', 'T', 'R', 'A', 'C', 'E'};
+
+// What replaying a trace did to one process
+typedef struct ReplayFootprint {
+    long accesses;
+    long pages; // pages mapped on first touch
+} ReplayFootprint;
+
+typedef struct ReplayState {
+    Simulator *sim;
+    std::unordered_map<uint32_t, ReplayFootprint> footprints;
+    uint32_t last_pid; // most traces touch the same process many times in a row
+    ReplayFootprint *last_footprint;
+    long accesses;
+    long invalid;
+    uint8_t checksum; // folds in every byte read so the reads are not optimized away
+} ReplayState;
+
+/*
+ * Runs one access, mapping its page first if the process has never touched it
+ */
+static void replayAccess(ReplayState *state, uint32_t pid, uint32_t virtual_address, bool write) {
+    if (virtual_address > INT32_MAX || pid > max_trace_pid) {
+        state->invalid++;
+        return;
+    }
+    if (state->last_footprint == NULL || pid != state->last_pid) {
+        state->last_pid = pid;
+        state->last_footprint = &state->footprints[pid];
+    }
+    PageTable *pageTable = state->sim->pageTable;
+    long physical_address = pageTable->getPhysicalAddress(pid, virtual_address);
+    bool first_touch = false;
+    if (physical_address == -1) {
+        pageTable->addEntry(pid, virtual_address / state->sim->page_size);
+        first_touch = true;
+        physical_address = pageTable->getPhysicalAddress(pid, virtual_address);
+    }
+    uint8_t *byte = physical_address == -1 ? NULL : state->sim->memory->access(physical_address, 1, write);
+    if (byte == NULL) {
+        state->invalid++;
+        return;
+    }
+    // only pages that could be accessed count towards the footprint
+    if (first_touch) {
+        state->last_footprint->pages++;
+    }
+    if (write) {
+        *byte = (uint8_t)state->accesses;
+    } else {
+        state->checksum ^= *byte;
+    }
+    state->last_footprint->accesses++;
+    state->accesses++;
+}
+
+// Parses an unsigned number in decimal or 0x hex, stopping at end
+static bool parseTraceNumber(const char **text, const char *end, uint32_t *value) {
+    const char *p = *text;
+    int base = 10;
+    if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        base = 16;
+        p += 2;
+    }
+    uint64_t number = 0;
+    const char *start = p;
+    for (; p < end; p++) {
+        int digit;
+        if (*p >= '0' && *p <= '9') {
+            digit = *p - '0';
+        } else if (base == 16 && *p >= 'a' && *p <= 'f') {
+            digit = *p - 'a' + 10;
+        } else if (base == 16 && *p >= 'A' && *p <= 'F') {
+            digit = *p - 'A' + 10;
+        } else {
+            break;
+        }
+        number = number * base + digit;
+        if (number > UINT32_MAX) {
+            return false;
+        }
+    }
+    *text = p;
+    *value = number;
+    return p > start;
+}
+
+static void skipSpaces(const char **text, const char *end) {
+    while (*text < end && (**text == ' ' || **text == '\t' || **text == '\r')) {
+        (*text)++;
+    }
+}
+
+static void replayText(ReplayState *state, const char *text, const char *end) {
+    while (text < end) {
+        const char *line_end = (const char *)memchr(text, '\n', end - text);
+        if (line_end == NULL) {
+            line_end = end;
+        }
+        const char *p = text;
+        skipSpaces(&p, line_end);
+        if (p < line_end && *p != '#') {
+            uint32_t pid;
+            uint32_t virtual_address;
+            bool valid = parseTraceNumber(&p, line_end, &pid);
+            skipSpaces(&p, line_end);
+            valid = valid && parseTraceNumber(&p, line_end, &virtual_address);
+            skipSpaces(&p, line_end);
+            valid = valid && p < line_end && (*p == 'r' || *p == 'w');
+            if (valid) {
+                replayAccess(state, pid, virtual_address, *p == 'w');
+            } else {
+                state->invalid++;
+            }
+        }
+        text = line_end + 1;
+    }
+}
+
+static void replayBinary(ReplayState *state, const TraceRecord *records, long count) {
+    for (long i = 0; i < count; i++) {
+        replayAccess(state, records[i].pid, records[i].virtual_address, records[i].flags & TRACE_WRITE);
+    }
+}
+
+/*
+ * Replays a trace file and prints the access rate, page faults and the footprint of each process
+ * Returns false if the trace could not be opened
+ */
+bool replayTrace(const char *path, Simulator *sim) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd == -1) {
+        return false;
+    }
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        return false;
+    }
+    const char *trace = NULL;
+    if (info.st_size > 0) {
+        void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        trace = (const char *)mapped;
+        // the trace is read front to back exactly once
+        madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+    } else {
+        close(fd);
+    }
+
+    ReplayState state;
+    state.sim = sim;
+    state.last_pid = 0;
+    state.last_footprint = NULL;
+    state.accesses = 0;
+    state.invalid = 0;
+    state.checksum = 0;
+
+    long swap_faults = sim->pageTable->getFaultCount();
+    auto start = std::chrono::steady_clock::now();
+    if (info.st_size >= (long)sizeof(trace_magic) && memcmp(trace, trace_magic, sizeof(trace_magic)) == 0) {
+        // a partial record at the end is ignored
+        replayBinary(&state, (const TraceRecord *)(trace + sizeof(trace_magic)),
+                     (info.st_size - sizeof(trace_magic)) / sizeof(TraceRecord));
+    } else {
+        replayText(&state, trace, trace + info.st_size);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    swap_faults = sim->pageTable->getFaultCount() - swap_faults;
+
+    if (trace != NULL) {
+        munmap((void *)trace, info.st_size);
+    }
+
+    long first_touch_faults = 0;
+    std::vector<uint32_t> pids;
+    for (auto it = state.footprints.begin(); it != state.footprints.end(); ++it) {
+        first_touch_faults += it->second.pages;
+        pids.push_back(it->first);
+    }
+    std::sort(pids.begin(), pids.end());
+
+    std::cout << "Accesses:   " << state.accesses << " (" << state.invalid << " invalid) in " << elapsed.count()
+              << " s, " << (long)(elapsed.count() > 0 ? state.accesses / elapsed.count() : 0) << " accesses/s"
+              << '\n';
+    std::cout << "Faults:     " << first_touch_faults << " first touch, " << swap_faults << " from swap" << '\n';
+    std::cout << " PID  |   Accesses   | Pages |  Footprint" << '\n';
+    std::cout << "------+--------------+-------+-------------" << '\n';
+    for (int i = 0; i < pids.size(); i++) {
+        ReplayFootprint *footprint = &state.footprints[pids[i]];
+        std::cout << " " << std::setw(4) << std::right << pids[i] << " | ";
+        std::cout << std::setw(12) << std::right << footprint->accesses << " | ";
+        std::cout << std::setw(5) << std::right << footprint->pages << " | ";
+        std::cout << std::setw(11) << std::right << (long)footprint->pages * sim->page_size << '\n';
+    }
+    return true;
+}
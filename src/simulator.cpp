@@ -0,0 +1,573 @@
+#include "simulator.h"
+#include "virtualcopy.h"
+#include "command.h"
+#include <algorithm>
+#include <cstring>
+
+template<DataType type>
+void print_physical_data(int pid, int virtual_address, int size, PageTable *pageTable, PhysicalMemory *memory);
+
+template<DataType type>
+bool set_physical_data(int pid, Variable *variable, int offset, char **values, int count, PageTable *pageTable, PhysicalMemory *memory);
+
+template<DataType type>
+bool fill_physical_data(int pid, Variable *variable, int offset, int count, const char *value, PageTable *pageTable, PhysicalMemory *memory);
+
+/*
+ * create <text_size> <data_size>
+ * - Initializes a new process
+ *   - Assign a PID - unique number (start at 1024 and increment up)
+ *   - Allocate some amount of startup memory for the process
+ *     - Text/Code: user specified number (2048 - 16384 bytes)
+ *     - Data/Globals: user specified number (0 - 1024 bytes)
+ *     - Stack: constant (65536 bytes)
+ * - Prints the PID
+ *
+ * > create 5992 564
+ * return: 1024
+ */
+void create(int text_size, int data_size, Mmu *mmu, PageTable *pageTable, int page_size) {
+
+    // text_size needs to be between 2048 and 16384
+    // data_size needs to be between 0 and 1024
+    // Print error if not
+    if (text_size < 2048 || text_size > 16384 || data_size < 0 || data_size > 1024) {
+        std::cout << "Text/Code size needs to be between 2048 and 16384 bytes. ";
+        std::cout << "Data/Globals size needs to be between 0 and 1024 bytes. " << '\n';
+        return;
+    }
+    int stack_size = 65536; // Stack is constant 65536 bytes
+
+    // Create process and get returned the pid (process id)
+    int pid = mmu->createProcess(); // pid starts at 1024
+    std::cout << pid << '\n';
+
+    // Create <TEXT>, <GLOBALS>, and <STACK> variables
+    addVariable(pid, "<TEXT>", text_size, TYPE_CHAR, mmu, pageTable, page_size);
+    addVariable(pid, "<GLOBALS>", data_size, TYPE_CHAR, mmu, pageTable, page_size);
+    addVariable(pid, "<STACK>", stack_size, TYPE_CHAR, mmu, pageTable, page_size);
+}
+
+/*
+Allocate memory on the heap
+  - N chars (N bytes)
+  - N shorts (N * 2 bytes)
+  - N ints / floats (N * 4 bytes)
+  - N longs / doubles (N * 8 bytes)
+
+allocate <PID> <var_name> <data_type> <number_of_elements>
+Allocated memory on the heap (how much depends on the data type and the number of elements)
+Print the virtual memory address
+ */
+void allocate(int pid, std::string var_name, std::string data_type, int number_of_elements, Mmu *mmu, PageTable *pageTable, int page_size) {
+    if(mmu->getProcess(pid) == NULL){
+        std::cout << pid << " is not a running process." << '\n';
+        return;
+    }
+
+    DataType type = parseDataType(data_type);
+    if(type == TYPE_NONE){
+        std::cout << data_type << " is not a valid data_type." << '\n';
+        return;
+    }
+
+    if(mmu->getVariableFromProcess(pid, var_name) != NULL){
+        std::cout << var_name << " already exists in process " << pid << "." << '\n';
+        return;
+    }
+
+    int number_of_bytes = number_of_elements;
+    number_of_bytes *= data_type_sizes[type];
+
+    int var_virtual_address = addVariable(pid, var_name, number_of_bytes, type, mmu, pageTable, page_size);
+    // if can't fit in memory then error
+    if(var_virtual_address == -1) {
+        std::cout << "Allocation would exceed system memory. No allocation performed." << '\n';
+    } else {
+        // print virtual address
+        std::cout << var_virtual_address << '\n';
+    }
+}
+
+int addVariable(int pid, std::string var_name, int size, DataType type, Mmu *mmu, PageTable *pageTable, int page_size) {
+    // Use first fit algorithm within a page when allocating new data
+
+    // Add variable to process, variables of a large page or more start on a large page so they can use them
+    int large_page_size = page_size * pageTable->getLargePages();
+    int var_virtual_address;
+    if(pageTable->getLargePages() > 1 && size >= large_page_size){
+        var_virtual_address = mmu->addAlignedVariableToProcess(pid, var_name, size, type, large_page_size);
+    } else {
+        var_virtual_address = mmu->addVariableToProcess(pid, var_name, size, type);
+    }
+    // Allocation would exceed system memory. No allocation performed.
+    if(var_virtual_address != -1){
+        mapVariablePages(pid, var_virtual_address, size, pageTable, page_size);
+    }
+
+    return var_virtual_address;
+}
+
+void set(int pid, std::string var_name, int offset, char **values, int count, Mmu *mmu, PageTable *pageTable, int page_size, PhysicalMemory *memory) {
+    if(mmu->getProcess(pid) == NULL){
+        std::cout << pid << " is not a running process." << '\n';
+        return;
+    }
+
+    Variable* variable = mmu->getVariableFromProcess(pid, var_name);
+    if(variable == NULL){
+        std::cout << var_name << " is not a variable in process " << pid << "." << '\n';
+        return;
+    }
+
+    switch(variable->type){
+        case TYPE_CHAR:
+            set_physical_data<TYPE_CHAR>(pid, variable, offset, values, count, pageTable, memory);
+            break;
+        case TYPE_SHORT:
+            set_physical_data<TYPE_SHORT>(pid, variable, offset, values, count, pageTable, memory);
+            break;
+        case TYPE_INT:
+            set_physical_data<TYPE_INT>(pid, variable, offset, values, count, pageTable, memory);
+            break;
+        case TYPE_FLOAT:
+            set_physical_data<TYPE_FLOAT>(pid, variable, offset, values, count, pageTable, memory);
+            break;
+        case TYPE_LONG:
+            set_physical_data<TYPE_LONG>(pid, variable, offset, values, count, pageTable, memory);
+            break;
+        case TYPE_DOUBLE:
+            set_physical_data<TYPE_DOUBLE>(pid, variable, offset, values, count, pageTable, memory);
+            break;
+        default:
+            break;
+    }
+}
+
+template<DataType type>
+bool set_physical_data(int pid, Variable *variable, int offset, char **values, int count, PageTable *pageTable, PhysicalMemory *memory){
+    typedef typename DataTypeTraits<type>::value_type T;
+    int bytes = sizeof(T);
+    if(offset < 0 || count < 0 || ((long)offset + count) * bytes > variable->size){
+        std::cout << "Setting " << count << " values at offset " << offset << " would go past the end of "
+                  << *variable->name << "." << '\n';
+        return false;
+    }
+
+    std::vector<T> new_values(count);
+    for(int i = 0; i < count; i++){
+        if(!DataTypeTraits<type>::parse(values[i], &new_values[i])){
+            std::cout << values[i] << " is not a valid " << data_type_names[type] << " value." << '\n';
+            return false;
+        }
+    }
+    // copy page by page into whichever frames the variable's pages are mapped to
+    int virtual_address = variable->virtual_address + offset * bytes;
+    if(!copyToVirtual(pageTable, memory, pid, virtual_address, new_values.data(), (long)count * bytes)){
+        std::cout << *variable->name << " is not backed by physical memory." << '\n';
+        return false;
+    }
+    return true;
+}
+
+void printVariable(int pid, std::string name, Mmu *mmu, PageTable *pageTable, PhysicalMemory *memory){
+    if(mmu->getProcess(pid) == NULL){
+        std::cout << pid << " is not a running process." << '\n';
+        return;
+    }
+
+    Variable* variable = mmu->getVariableFromProcess(pid, name);
+    if(variable == NULL){
+        std::cout << name << " is not a variable in process " << pid << "." << '\n';
+        return;
+    }
+
+    int virtual_address = variable->virtual_address;
+
+    int size = variable->size;
+
+    switch(variable->type){
+        case TYPE_CHAR:
+            print_physical_data<TYPE_CHAR>(pid, virtual_address, size, pageTable, memory);
+            break;
+        case TYPE_SHORT:
+            print_physical_data<TYPE_SHORT>(pid, virtual_address, size, pageTable, memory);
+            break;
+        case TYPE_INT:
+            print_physical_data<TYPE_INT>(pid, virtual_address, size, pageTable, memory);
+            break;
+        case TYPE_FLOAT:
+            print_physical_data<TYPE_FLOAT>(pid, virtual_address, size, pageTable, memory);
+            break;
+        case TYPE_LONG:
+            print_physical_data<TYPE_LONG>(pid, virtual_address, size, pageTable, memory);
+            break;
+        case TYPE_DOUBLE:
+            print_physical_data<TYPE_DOUBLE>(pid, virtual_address, size, pageTable, memory);
+            break;
+        default:
+            break;
+    }
+    std::cout << '\n';
+}
+
+template<DataType type>
+void print_physical_data(int pid, int virtual_address, int size, PageTable *pageTable, PhysicalMemory *memory){
+    typedef typename DataTypeTraits<type>::value_type T;
+    int number_of_values = size / (int)sizeof(T);
+    // only the first 4 values are ever printed
+    T values[4];
+    int count = std::min(number_of_values, 4);
+    if(!copyFromVirtual(pageTable, memory, pid, virtual_address, values, (long)count * sizeof(T))){
+        std::cout << "Variable is not backed by physical memory.";
+        return;
+    }
+
+    for(int i = 0; i < number_of_values; i++){
+        if(i > 3){
+            std::cout << "... [" << number_of_values << " items]";
+            break;
+        }
+        formatValue<type>(std::cout, values[i]);
+        if(i < number_of_values-1){
+            std::cout << ", ";
+        }
+    }
+}
+
+// Returns a variable of a running process, or prints why there is none and returns NULL
+static Variable *findVariable(int pid, const std::string &name, Mmu *mmu){
+    if(mmu->getProcess(pid) == NULL){
+        std::cout << pid << " is not a running process." << '\n';
+        return NULL;
+    }
+    Variable *variable = mmu->getVariableFromProcess(pid, name);
+    if(variable == NULL){
+        std::cout << name << " is not a variable in process " << pid << "." << '\n';
+    }
+    return variable;
+}
+
+/*
+ * fill <PID> <var_name> <offset> <count> <value>
+ * - Sets count values of a variable, starting at offset, to one value
+ * - The value is parsed once and written a page at a time
+ */
+void fill(int pid, std::string var_name, int offset, int count, const char *value, Mmu *mmu, PageTable *pageTable,
+          PhysicalMemory *memory){
+    Variable *variable = findVariable(pid, var_name, mmu);
+    if(variable == NULL){
+        return;
+    }
+
+    switch(variable->type){
+        case TYPE_CHAR:
+            fill_physical_data<TYPE_CHAR>(pid, variable, offset, count, value, pageTable, memory);
+            break;
+        case TYPE_SHORT:
+            fill_physical_data<TYPE_SHORT>(pid, variable, offset, count, value, pageTable, memory);
+            break;
+        case TYPE_INT:
+            fill_physical_data<TYPE_INT>(pid, variable, offset, count, value, pageTable, memory);
+            break;
+        case TYPE_FLOAT:
+            fill_physical_data<TYPE_FLOAT>(pid, variable, offset, count, value, pageTable, memory);
+            break;
+        case TYPE_LONG:
+            fill_physical_data<TYPE_LONG>(pid, variable, offset, count, value, pageTable, memory);
+            break;
+        case TYPE_DOUBLE:
+            fill_physical_data<TYPE_DOUBLE>(pid, variable, offset, count, value, pageTable, memory);
+            break;
+        default:
+            break;
+    }
+}
+
+template<DataType type>
+bool fill_physical_data(int pid, Variable *variable, int offset, int count, const char *value, PageTable *pageTable, PhysicalMemory *memory){
+    typedef typename DataTypeTraits<type>::value_type T;
+    if(offset < 0 || count < 0 || ((long)offset + count) * sizeof(T) > variable->size){
+        std::cout << "Filling " << count << " values at offset " << offset << " would go past the end of "
+                  << *variable->name << "." << '\n';
+        return false;
+    }
+    T parsed;
+    if(!DataTypeTraits<type>::parse(value, &parsed)){
+        std::cout << value << " is not a valid " << data_type_names[type] << " value." << '\n';
+        return false;
+    }
+    int virtual_address = variable->virtual_address + offset * (int)sizeof(T);
+    if(!fillVirtual(pageTable, memory, pid, virtual_address, &parsed, sizeof(T), count)){
+        std::cout << *variable->name << " is not backed by physical memory." << '\n';
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Checks that count values fit in both variables and that they hold the same type
+ * Returns the number of bytes the values take, or -1 after printing why they do not fit
+ */
+static long getTransferLength(Variable *a, Variable *b, int count, const char *verb){
+    if(a->type != b->type){
+        std::cout << *a->name << " and " << *b->name << " do not have the same data_type." << '\n';
+        return -1;
+    }
+    long length = (long)count * data_type_sizes[a->type];
+    if(count < 0 || length > a->size || length > b->size){
+        std::cout << verb << " " << count << " values would go past the end of "
+                  << *(length > a->size ? a->name : b->name) << "." << '\n';
+        return -1;
+    }
+    return length;
+}
+
+/*
+ * copy <PID_A> <source> <PID_B> <destination> <count>
+ * - Copies the first count values of one variable to another variable of the same type
+ * - The variables can be in the same or different processes, and can be in shared frames
+ */
+void copy(int source_pid, std::string source_name, int destination_pid, std::string destination_name, int count,
+          Mmu *mmu, PageTable *pageTable, PhysicalMemory *memory){
+    Variable *source = findVariable(source_pid, source_name, mmu);
+    Variable *destination = source == NULL ? NULL : findVariable(destination_pid, destination_name, mmu);
+    if(destination == NULL){
+        return;
+    }
+    long length = getTransferLength(source, destination, count, "Copying");
+    if(length == -1){
+        return;
+    }
+    if(!copyVirtual(pageTable, memory, source_pid, source->virtual_address, destination_pid,
+                    destination->virtual_address, length)){
+        std::cout << source_name << " or " << destination_name << " is not backed by physical memory." << '\n';
+    }
+}
+
+/*
+ * cmp <PID_A> <var_a> <PID_B> <var_b> <count>
+ * - Compares the first count values of two variables of the same type
+ * - Prints whether they are equal, or the first value that differs
+ */
+void compare(int pid_a, std::string name_a, int pid_b, std::string name_b, int count, Mmu *mmu, PageTable *pageTable,
+             PhysicalMemory *memory){
+    Variable *a = findVariable(pid_a, name_a, mmu);
+    Variable *b = a == NULL ? NULL : findVariable(pid_b, name_b, mmu);
+    if(b == NULL){
+        return;
+    }
+    long length = getTransferLength(a, b, count, "Comparing");
+    if(length == -1){
+        return;
+    }
+    long difference;
+    if(!compareVirtual(pageTable, memory, pid_a, a->virtual_address, pid_b, b->virtual_address, length,
+                       &difference)){
+        std::cout << name_a << " or " << name_b << " is not backed by physical memory." << '\n';
+    } else if(difference == -1){
+        std::cout << name_a << " and " << name_b << " are equal." << '\n';
+    } else {
+        std::cout << name_a << " and " << name_b << " differ at value "
+                  << difference / data_type_sizes[a->type] << "." << '\n';
+    }
+}
+
+void free(int pid, std::string name, Mmu *mmu, PageTable *pageTable, int page_size){
+    if(mmu->getProcess(pid) == NULL){
+        std::cout << pid << " is not a running process." << '\n';
+        return;
+    }
+    Variable *variable = mmu->getVariableFromProcess(pid, name);
+    if(variable == NULL){
+        std::cout << name << " is not a variable in process " << pid << "." << '\n';
+        return;
+    }
+
+    int size = variable->size;
+    int virtual_address = variable->virtual_address;
+
+    // give the variable's space back to the process's heap and merge it with free space next to it
+    mmu->freeVariable(pid, variable);
+
+    unmapVariablePages(pid, virtual_address, size, pageTable, page_size);
+}
+
+/*
+ * First and last pages that hold bytes of a variable
+ * An empty variable still counts as being on the page its address is in
+ */
+void getPageRange(int virtual_address, int size, int page_size, int *first_page_number, int *last_page_number){
+    *first_page_number = virtual_address / page_size;
+    *last_page_number = size > 0 ? (virtual_address + size - 1) / page_size : *first_page_number;
+}
+
+/*
+ * Large pages that lie entirely inside a variable, the range is empty (first > last) if there are none
+ * No other variable has bytes on them, so they can be mapped as a whole
+ */
+void getLargePageRange(int virtual_address, int size, int large_page_size, int *first_large_page_number,
+                       int *last_large_page_number){
+    *first_large_page_number = (int)(((long)virtual_address + large_page_size - 1) / large_page_size);
+    *last_large_page_number = (int)(((long)virtual_address + size) / large_page_size) - 1;
+}
+
+/*
+ * Each page the variable is on gets a reference, pages are mapped on their first one
+ * With large pages, the large pages inside the variable are mapped instead of the pages they cover
+ */
+void mapVariablePages(int pid, int virtual_address, int size, PageTable *pageTable, int page_size){
+    int first_page_number;
+    int last_page_number;
+    getPageRange(virtual_address, size, page_size, &first_page_number, &last_page_number);
+    int large_pages = pageTable->getLargePages();
+    int first_large_page_number = 0;
+    int last_large_page_number = -1;
+    if(large_pages > 1){
+        getLargePageRange(virtual_address, size, page_size * large_pages, &first_large_page_number,
+                          &last_large_page_number);
+    }
+    for(int page = first_page_number; page <= last_page_number; page++){
+        if(page / large_pages < first_large_page_number || page / large_pages > last_large_page_number){
+            pageTable->addEntry(pid, page);
+        }
+    }
+    for(int large_page = first_large_page_number; large_page <= last_large_page_number; large_page++){
+        pageTable->addLargeEntry(pid, large_page);
+    }
+}
+
+/*
+ * Each page the variable was on loses its reference, pages with no variables left are unmapped
+ */
+void unmapVariablePages(int pid, int virtual_address, int size, PageTable *pageTable, int page_size){
+    int first_page_number;
+    int last_page_number;
+    getPageRange(virtual_address, size, page_size, &first_page_number, &last_page_number);
+    int large_pages = pageTable->getLargePages();
+    int first_large_page_number = 0;
+    int last_large_page_number = -1;
+    if(large_pages > 1){
+        getLargePageRange(virtual_address, size, page_size * large_pages, &first_large_page_number,
+                          &last_large_page_number);
+    }
+    for(int page = first_page_number; page <= last_page_number; page++){
+        if(page / large_pages < first_large_page_number || page / large_pages > last_large_page_number){
+            pageTable->removeEntry(pid, page);
+        }
+    }
+    for(int large_page = first_large_page_number; large_page <= last_large_page_number; large_page++){
+        pageTable->removeLargeEntry(pid, large_page);
+    }
+}
+
+void terminate(int pid, Mmu *mmu, PageTable *pageTable, int page_size){
+    if(mmu->getProcess(pid) == NULL){
+        std::cout << pid << " is not a running process." << '\n';
+        return;
+    }
+    mmu->terminateProcess(pid);
+    pageTable->removeProcess(pid);
+}
+
+// Copies a process, its pages share frames with the parent until one of them writes
+void fork(int pid, Mmu *mmu, PageTable *pageTable) {
+    int child_pid = mmu->forkProcess(pid);
+    if (child_pid == -1) {
+        std::cout << pid << " is not a running process." << '\n';
+        return;
+    }
+    pageTable->forkProcess(pid, child_pid);
+    std::cout << child_pid << '\n';
+}
+
+/*
+ * Moves a variable to pages that no other block has bytes on, its data is copied over
+ * Returns the moved variable, or NULL if it could not be moved and was left where it was
+ */
+static Variable *moveToOwnPages(int pid, Variable *variable, Mmu *mmu, PageTable *pageTable, int page_size,
+                                PhysicalMemory *memory){
+    // the name is taken until the old variable is freed, command arguments never have spaces in them
+    const std::string moving_name = "<moving variable>";
+    std::string name = *variable->name;
+    int size = variable->size;
+    int old_address = variable->virtual_address;
+    int new_address = mmu->addPageAlignedVariableToProcess(pid, moving_name, size, variable->type, page_size, 0);
+    if(new_address == -1){
+        std::cout << "Allocation would exceed system memory. No allocation performed." << '\n';
+        return NULL;
+    }
+    mapVariablePages(pid, new_address, size, pageTable, page_size);
+    if(!copyVirtual(pageTable, memory, pid, old_address, pid, new_address, size)){
+        std::cout << name << " is not backed by physical memory." << '\n';
+        free(pid, moving_name, mmu, pageTable, page_size);
+        return NULL;
+    }
+    free(pid, name, mmu, pageTable, page_size);
+    Variable *moved = mmu->getVariableFromProcess(pid, moving_name);
+    mmu->renameVariable(pid, moved, name);
+    std::cout << name << " was moved to " << new_address << " to have pages of its own." << '\n';
+    return moved;
+}
+
+/*
+ * share <PID_A> <var_name> <PID_B> <name>
+ * - Maps the pages of a variable of process A into process B as a new variable
+ *   - A's variable is moved to pages of its own first if other blocks have bytes on its pages
+ *   - B's variable gets pages of its own, with its data at the same offset into the first page
+ *   - Both processes write to the same frames, which are released when the last of them is freed
+ * - Prints the virtual address of the variable in process B
+ */
+void share(int pid, std::string var_name, int target_pid, std::string target_name, Mmu *mmu, PageTable *pageTable,
+           int page_size, PhysicalMemory *memory) {
+    if(mmu->getProcess(pid) == NULL){
+        std::cout << pid << " is not a running process." << '\n';
+        return;
+    }
+    if(mmu->getProcess(target_pid) == NULL){
+        std::cout << target_pid << " is not a running process." << '\n';
+        return;
+    }
+    Variable *variable = mmu->getVariableFromProcess(pid, var_name);
+    if(variable == NULL){
+        std::cout << var_name << " is not a variable in process " << pid << "." << '\n';
+        return;
+    }
+    if(mmu->getVariableFromProcess(target_pid, target_name) != NULL){
+        std::cout << target_name << " already exists in process " << target_pid << "." << '\n';
+        return;
+    }
+    // shared segments are mapped page by page, large pages would have to line up in both processes
+    if(pageTable->getLargePages() > 1){
+        std::cout << "Variables can not be shared when large pages are used." << '\n';
+        return;
+    }
+
+    // shared pages are written in place even after a fork, so they can only hold the shared variable
+    int block_start = variable->virtual_address - variable->padding_before;
+    int block_end = variable->virtual_address + variable->size + variable->padding_after;
+    if(block_start % page_size != 0 || block_end % page_size != 0){
+        variable = moveToOwnPages(pid, variable, mmu, pageTable, page_size, memory);
+        if(variable == NULL){
+            return;
+        }
+    }
+
+    int first_page_number;
+    int last_page_number;
+    getPageRange(variable->virtual_address, variable->size, page_size, &first_page_number, &last_page_number);
+    int target_address = mmu->addPageAlignedVariableToProcess(target_pid, target_name, variable->size,
+                                                              variable->type, page_size,
+                                                              variable->virtual_address % page_size);
+    if(target_address == -1){
+        std::cout << "Allocation would exceed system memory. No allocation performed." << '\n';
+        return;
+    }
+    if(!pageTable->sharePages(pid, first_page_number, target_pid, target_address / page_size,
+                              last_page_number - first_page_number + 1)){
+        std::cout << var_name << " is not backed by physical memory." << '\n';
+        free(target_pid, target_name, mmu, pageTable, page_size);
+        return;
+    }
+    std::cout << target_address << '\n';
+}
@@ -0,0 +1,170 @@
+#include "stats.h"
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+typedef struct StatThreadHistograms {
+    StatHistogram histograms[STAT_OPERATION_COUNT];
+} StatThreadHistograms;
+
+// Histograms of the running threads, and the sums of the threads that have exited
+static std::mutex stat_threads_lock;
+static std::vector<StatThreadHistograms *> stat_threads;
+static StatThreadHistograms exited_threads;
+
+static thread_local StatThreadHistograms *thread_histograms = NULL;
+
+// Adds one set of histograms to another, callers hold stat_threads_lock
+static void addHistograms(StatThreadHistograms *to, StatThreadHistograms *from) {
+    for (int i = 0; i < STAT_OPERATION_COUNT; i++) {
+        StatHistogram *to_histogram = &to->histograms[i];
+        StatHistogram *from_histogram = &from->histograms[i];
+        to_histogram->total_ticks.store(to_histogram->total_ticks.load(std::memory_order_relaxed) +
+                                        from_histogram->total_ticks.load(std::memory_order_relaxed),
+                                        std::memory_order_relaxed);
+        for (int bucket = 0; bucket < stat_buckets; bucket++) {
+            to_histogram->buckets[bucket].store(to_histogram->buckets[bucket].load(std::memory_order_relaxed) +
+                                                from_histogram->buckets[bucket].load(std::memory_order_relaxed),
+                                                std::memory_order_relaxed);
+        }
+    }
+}
+
+// Folds a thread's histograms into exited_threads when the thread ends
+class StatThreadRegistration {
+public:
+    ~StatThreadRegistration() {
+        std::lock_guard<std::mutex> guard(stat_threads_lock);
+        for (int i = 0; i < stat_threads.size(); i++) {
+            if (stat_threads[i] == thread_histograms) {
+                stat_threads.erase(stat_threads.begin() + i);
+                break;
+            }
+        }
+        addHistograms(&exited_threads, thread_histograms);
+        delete thread_histograms;
+        thread_histograms = NULL;
+    }
+};
+
+static StatThreadHistograms *registerStatThread() {
+    static thread_local StatThreadRegistration registration;
+    (void)registration;
+    StatThreadHistograms *histograms = new StatThreadHistograms(); // zeroed
+    std::lock_guard<std::mutex> guard(stat_threads_lock);
+    stat_threads.push_back(histograms);
+    thread_histograms = histograms;
+    return histograms;
+}
+
+const char *stat_names[STAT_OPERATION_COUNT] = {
+        "create",
+        "allocate",
+        "set",
+        "print",
+        "free",
+        "terminate",
+        "fork",
+        "share",
+        "save",
+        "load",
+        "fill",
+        "copy",
+        "cmp",
+        "translate",
+        "frame allocate",
+        "heap allocate",
+        "variable lookup",
+        "coalesce",
+        "page fault",
+        "eviction"
+};
+
+// Ticks and time at startup, to work out how long a tick is
+static const uint64_t start_ticks = readStatTicks();
+static const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+/*
+ * Adds a latency to the calling thread's histogram
+ * Relaxed loads and stores instead of read-modify-writes, the owning thread
+ * is the only writer so these are plain adds with no locked instructions
+ */
+void recordStat(StatOperation operation, uint64_t ticks) {
+    StatThreadHistograms *histograms = thread_histograms;
+    if (histograms == NULL) {
+        histograms = registerStatThread();
+    }
+    StatHistogram *histogram = &histograms->histograms[operation];
+    int bucket = ticks == 0 ? 0 : 64 - __builtin_clzll(ticks);
+    if (bucket >= stat_buckets) {
+        bucket = stat_buckets - 1;
+    }
+    histogram->total_ticks.store(histogram->total_ticks.load(std::memory_order_relaxed) + ticks,
+                                 std::memory_order_relaxed);
+    histogram->buckets[bucket].store(histogram->buckets[bucket].load(std::memory_order_relaxed) + 1,
+                                     std::memory_order_relaxed);
+}
+
+static uint64_t getCount(StatHistogram *histogram) {
+    uint64_t count = 0;
+    for (int bucket = 0; bucket < stat_buckets; bucket++) {
+        count += histogram->buckets[bucket].load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+// Upper bound of the bucket the given fraction of calls fall in, in ticks
+static uint64_t getPercentile(StatHistogram *histogram, uint64_t count, double fraction) {
+    uint64_t target = (uint64_t)(count * fraction);
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < stat_buckets; bucket++) {
+        seen += histogram->buckets[bucket].load(std::memory_order_relaxed);
+        if (seen > target) {
+            return 1ULL << bucket;
+        }
+    }
+    return 1ULL << (stat_buckets - 1);
+}
+
+/*
+ * Print call counts and latencies of every operation that has been called
+ * Percentiles are the upper bound of their histogram bucket
+ * initiated by command 'print stats' and --stats
+ */
+void printStats(std::ostream &out) {
+#ifdef MEMSIM_NO_STATS
+    out << "Stats are compiled out of this build." << '\n';
+#else
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start_time;
+    uint64_t ticks = readStatTicks() - start_ticks;
+    double ns_per_tick = ticks > 0 ? elapsed.count() / ticks : 1.0;
+
+    // counts of running threads can be a few samples behind
+    StatThreadHistograms *totals = new StatThreadHistograms(); // zeroed
+    {
+        std::lock_guard<std::mutex> guard(stat_threads_lock);
+        addHistograms(totals, &exited_threads);
+        for (int i = 0; i < stat_threads.size(); i++) {
+            addHistograms(totals, stat_threads[i]);
+        }
+    }
+
+    out << " Operation       |    Calls     |   Mean ns   |  p50 ns  |  p90 ns  |  p99 ns" << '\n';
+    out << "-----------------+--------------+-------------+----------+----------+----------" << '\n';
+    for (int i = 0; i < STAT_OPERATION_COUNT; i++) {
+        StatHistogram *histogram = &totals->histograms[i];
+        uint64_t count = getCount(histogram);
+        if (count == 0) {
+            continue;
+        }
+        uint64_t mean = histogram->total_ticks.load(std::memory_order_relaxed) * ns_per_tick / count;
+        out << " " << std::setw(15) << std::left << stat_names[i] << " | ";
+        out << std::setw(12) << std::right << count << " | ";
+        out << std::setw(11) << std::right << mean << " | ";
+        out << std::setw(8) << std::right << (uint64_t)(getPercentile(histogram, count, 0.50) * ns_per_tick) << " | ";
+        out << std::setw(8) << std::right << (uint64_t)(getPercentile(histogram, count, 0.90) * ns_per_tick) << " | ";
+        out << std::setw(8) << std::right << (uint64_t)(getPercentile(histogram, count, 0.99) * ns_per_tick) << '\n';
+    }
+    delete totals;
+#endif
+}
@@ -0,0 +1,76 @@
+#include "swapfile.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+SwapFile::SwapFile(const std::string &path, int page_size) {
+    _path = path;
+    _page_size = page_size;
+    _page_outs = 0;
+    _page_ins = 0;
+    _bytes_written = 0;
+    _bytes_read = 0;
+    // Start from an empty file, nothing in it is valid after a restart
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+}
+
+SwapFile::~SwapFile() {
+    if (_fd != -1) {
+        close(_fd);
+    }
+}
+
+bool SwapFile::isOpen() {
+    return _fd != -1;
+}
+
+/*
+ * Writes a page to a free slot, returns the slot or -1 if the write failed
+ */
+int SwapFile::writePage(const uint8_t *page) {
+    int slot = _slots.allocate();
+    if (pwrite(_fd, page, _page_size, (off_t)slot * _page_size) != _page_size) {
+        _slots.release(slot);
+        return -1;
+    }
+    _page_outs++;
+    _bytes_written += _page_size;
+    return slot;
+}
+
+/*
+ * Reads the page in a slot back, the slot stays in use until it is released
+ */
+bool SwapFile::readPage(int slot, uint8_t *page) {
+    if (!_slots.isAllocated(slot) || pread(_fd, page, _page_size, (off_t)slot * _page_size) != _page_size) {
+        return false;
+    }
+    _page_ins++;
+    _bytes_read += _page_size;
+    return true;
+}
+
+/*
+ * Copies the page in a slot to a free slot, returns the new slot or -1 if the copy failed
+ */
+int SwapFile::copyPage(int slot) {
+    std::vector<uint8_t> page(_page_size);
+    if (!readPage(slot, page.data())) {
+        return -1;
+    }
+    return writePage(page.data());
+}
+
+void SwapFile::release(int slot) {
+    _slots.release(slot);
+}
+
+/*
+ * Print swap file usage and I/O
+ */
+void SwapFile::print() {
+    std::cout << "Swap file: " << _path << ", " << _slots.getUsedCount() << " slots in use ("
+              << (long)_slots.getUsedCount() * _page_size << " bytes)" << '\n';
+    std::cout << "Page outs: " << _page_outs << " (" << _bytes_written << " bytes written)" << '\n';
+    std::cout << "Page ins:  " << _page_ins << " (" << _bytes_read << " bytes read)" << '\n';
+}
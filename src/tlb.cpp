@@ -0,0 +1,193 @@
+#include "tlb.h"
+#include "conditionallock.h"
+
+Tlb::Tlb(int sets, int ways, TlbPolicy policy) {
+    _sets = sets;
+    _ways = ways;
+    _policy = policy;
+    _clock = 0;
+    _random_state = 2463534242u;
+    _concurrent = false;
+    _large_pages = 1;
+
+    TlbEntry empty = {false, 0, 0, false, 0, 0};
+    _entries.resize(sets * ways, empty);
+}
+
+Tlb::~Tlb() {
+}
+
+void Tlb::setConcurrent(bool concurrent) {
+    _concurrent = concurrent;
+}
+
+void Tlb::setLargePages(int pages) {
+    _large_pages = pages;
+}
+
+int Tlb::getSet(uint32_t pid, int page_number) {
+    // mix the pid in so processes using the same page numbers don't all collide
+    uint32_t hash = (uint32_t)page_number ^ (pid * 2654435761u);
+    return hash % _sets;
+}
+
+TlbStats *Tlb::getStats(uint32_t pid) {
+    if (pid >= _stats.size()) {
+        TlbStats empty = {0, 0};
+        _stats.resize(pid + 1, empty);
+    }
+    return &_stats[pid];
+}
+
+// Returns the valid entry for a page or a large page, or NULL, the caller holds the lock
+TlbEntry *Tlb::find(uint32_t pid, int page_number, bool large) {
+    TlbEntry *set = &_entries[getSet(pid, page_number) * _ways];
+    for (int i = 0; i < _ways; i++) {
+        if (set[i].valid && set[i].pid == pid && set[i].page_number == page_number && set[i].large == large) {
+            return &set[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Looks up the frame a page is mapped to, counting a hit or a miss for the pid
+ */
+bool Tlb::lookup(uint32_t pid, int page_number, int *frame) {
+    ConditionalLock lock(_lock, _concurrent);
+    TlbEntry *entry = find(pid, page_number, false);
+    if (entry != NULL) {
+        *frame = entry->frame;
+    } else if (_large_pages > 1 && (entry = find(pid, page_number / _large_pages, true)) != NULL) {
+        *frame = entry->frame + page_number % _large_pages;
+    } else {
+        getStats(pid)->misses++;
+        return false;
+    }
+    entry->last_used = ++_clock;
+    getStats(pid)->hits++;
+    return true;
+}
+
+void Tlb::insert(uint32_t pid, int page_number, int frame) {
+    ConditionalLock lock(_lock, _concurrent);
+    fill(pid, page_number, false, frame);
+}
+
+void Tlb::insertLarge(uint32_t pid, int large_page_number, int first_frame) {
+    ConditionalLock lock(_lock, _concurrent);
+    fill(pid, large_page_number, true, first_frame);
+}
+
+// Puts an entry in its set, the caller holds the lock
+void Tlb::fill(uint32_t pid, int page_number, bool large, int frame) {
+    TlbEntry *set = &_entries[getSet(pid, page_number) * _ways];
+
+    // Use an empty way if there is one, otherwise pick a victim
+    int victim = -1;
+    for (int i = 0; i < _ways; i++) {
+        if (!set[i].valid) {
+            victim = i;
+            break;
+        }
+    }
+    if (victim == -1) {
+        if (_policy == TLB_RANDOM) {
+            // xorshift32
+            _random_state ^= _random_state << 13;
+            _random_state ^= _random_state >> 17;
+            _random_state ^= _random_state << 5;
+            victim = _random_state % _ways;
+        } else {
+            victim = 0;
+            for (int i = 1; i < _ways; i++) {
+                if (set[i].last_used < set[victim].last_used) {
+                    victim = i;
+                }
+            }
+        }
+    }
+
+    set[victim].valid = true;
+    set[victim].pid = pid;
+    set[victim].page_number = page_number;
+    set[victim].large = large;
+    set[victim].frame = frame;
+    set[victim].last_used = ++_clock;
+}
+
+void Tlb::invalidate(uint32_t pid, int page_number) {
+    ConditionalLock lock(_lock, _concurrent);
+    TlbEntry *entry = find(pid, page_number, false);
+    if (entry != NULL) {
+        entry->valid = false;
+    }
+}
+
+void Tlb::invalidateLarge(uint32_t pid, int large_page_number) {
+    ConditionalLock lock(_lock, _concurrent);
+    TlbEntry *entry = find(pid, large_page_number, true);
+    if (entry != NULL) {
+        entry->valid = false;
+    }
+}
+
+void Tlb::invalidateProcess(uint32_t pid) {
+    ConditionalLock lock(_lock, _concurrent);
+    for (int i = 0; i < _entries.size(); i++) {
+        if (_entries[i].pid == pid) {
+            _entries[i].valid = false;
+        }
+    }
+}
+
+// Drops every entry, hit and miss counts are kept
+void Tlb::flush() {
+    ConditionalLock lock(_lock, _concurrent);
+    for (int i = 0; i < _entries.size(); i++) {
+        _entries[i].valid = false;
+    }
+}
+
+/*
+ * Print the TLB geometry and reach, then hits, misses and hit rate for each pid
+ * initiated by command 'print tlb'
+ */
+void Tlb::print(int page_size) {
+    ConditionalLock lock(_lock, _concurrent);
+    std::cout << "TLB: " << _sets << " sets x " << _ways << " ways ("
+              << (_policy == TLB_LRU ? "LRU" : "random") << "), "
+              << _sets * _ways << " entries, reach " << (long)_sets * _ways * page_size
+              << " bytes with " << page_size << " byte pages" << '\n';
+    if (_large_pages > 1) {
+        // what the entries that are in use cover right now
+        long base_entries = 0;
+        long large_entries = 0;
+        for (int i = 0; i < _entries.size(); i++) {
+            if (_entries[i].valid) {
+                (_entries[i].large ? large_entries : base_entries)++;
+            }
+        }
+        long large_page_size = (long)page_size * _large_pages;
+        std::cout << "Large pages: " << large_page_size << " bytes, reach up to " << (long)_sets * _ways * large_page_size
+                  << " bytes, now " << base_entries * page_size + large_entries * large_page_size << " bytes ("
+                  << base_entries << " base, " << large_entries << " large entries)" << '\n';
+    }
+
+    std::cout << " PID  |     Hits     |    Misses    | Hit Rate" << '\n';
+    std::cout << "------+--------------+--------------+----------" << '\n';
+    for (uint32_t pid = 0; pid < _stats.size(); pid++) {
+        uint64_t hits = _stats[pid].hits;
+        uint64_t misses = _stats[pid].misses;
+        if (hits + misses == 0) {
+            continue;
+        }
+        std::cout << " " << pid << " | ";
+        std::cout << std::setw(12) << std::right << hits << " | ";
+        std::cout << std::setw(12) << std::right << misses << " | ";
+        std::cout << std::setw(7) << std::right << std::fixed << std::setprecision(2)
+                  << 100.0 * hits / (hits + misses) << "%" << '\n';
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+}
@@ -0,0 +1,176 @@
+#include "virtualcopy.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+bool copyToVirtual(PageTable *pageTable, PhysicalMemory *memory, uint32_t pid, int virtual_address,
+                   const void *source, long length) {
+    const uint8_t *data = (const uint8_t *)source;
+    int page_size = pageTable->getPageSize();
+    while (length > 0) {
+        // bytes left on this page
+        long segment = page_size - (virtual_address % page_size);
+        if (segment > length) {
+            segment = length;
+        }
+        long physical_address = pageTable->getPhysicalAddress(pid, virtual_address, true);
+        uint8_t *destination = physical_address == -1 ? NULL : memory->access(physical_address, segment, true);
+        if (destination == NULL) {
+            return false;
+        }
+        std::memcpy(destination, data, segment);
+        data += segment;
+        virtual_address += segment;
+        length -= segment;
+    }
+    return true;
+}
+
+bool copyFromVirtual(PageTable *pageTable, PhysicalMemory *memory, uint32_t pid, int virtual_address,
+                     void *destination, long length) {
+    uint8_t *data = (uint8_t *)destination;
+    int page_size = pageTable->getPageSize();
+    while (length > 0) {
+        // bytes left on this page
+        long segment = page_size - (virtual_address % page_size);
+        if (segment > length) {
+            segment = length;
+        }
+        long physical_address = pageTable->getPhysicalAddress(pid, virtual_address);
+        uint8_t *source = physical_address == -1 ? NULL : memory->access(physical_address, segment, false);
+        if (source == NULL) {
+            return false;
+        }
+        std::memcpy(data, source, segment);
+        data += segment;
+        virtual_address += segment;
+        length -= segment;
+    }
+    return true;
+}
+
+bool fillVirtual(PageTable *pageTable, PhysicalMemory *memory, uint32_t pid, int virtual_address,
+                 const void *pattern, int pattern_size, long count) {
+    const uint8_t *bytes = (const uint8_t *)pattern;
+    int page_size = pageTable->getPageSize();
+    long length = count * pattern_size;
+    // patterns of one repeated byte, zero included, are a plain memset
+    bool repeated = true;
+    for (int i = 1; i < pattern_size; i++) {
+        repeated = repeated && bytes[i] == bytes[0];
+    }
+    // otherwise a page of the pattern, plus one more copy so a segment can start at any byte of it
+    std::vector<uint8_t> stripe;
+    if (!repeated) {
+        stripe.resize(page_size + pattern_size);
+        for (int i = 0; i < stripe.size(); i++) {
+            stripe[i] = bytes[i % pattern_size];
+        }
+    }
+    long done = 0;
+    while (done < length) {
+        // bytes left on this page
+        long segment = page_size - (virtual_address % page_size);
+        if (segment > length - done) {
+            segment = length - done;
+        }
+        long physical_address = pageTable->getPhysicalAddress(pid, virtual_address, true);
+        uint8_t *destination = physical_address == -1 ? NULL : memory->access(physical_address, segment, true);
+        if (destination == NULL) {
+            return false;
+        }
+        if (repeated) {
+            std::memset(destination, bytes[0], segment);
+        } else {
+            std::memcpy(destination, &stripe[done % pattern_size], segment);
+        }
+        virtual_address += segment;
+        done += segment;
+    }
+    return true;
+}
+
+/*
+ * Translates a page of each of two ranges so that both are in memory at once
+ * With swap, bringing in the second page can evict the first one and put the second in its
+ * frame, so the first is translated again until doing that evicts nothing. Returns false if
+ * either page is not mapped or the two can not be in memory together.
+ */
+static bool translatePair(PageTable *pageTable, uint32_t pid_a, int address_a, bool write_a, uint32_t pid_b,
+                          int address_b, bool write_b, long *physical_a, long *physical_b) {
+    *physical_a = pageTable->getPhysicalAddress(pid_a, address_a, write_a);
+    for (int attempt = 0; attempt < 4 && *physical_a != -1; attempt++) {
+        *physical_b = pageTable->getPhysicalAddress(pid_b, address_b, write_b);
+        if (*physical_b == -1) {
+            return false;
+        }
+        long evictions = pageTable->getEvictionCount();
+        *physical_a = pageTable->getPhysicalAddress(pid_a, address_a, write_a);
+        if (pageTable->getEvictionCount() == evictions) {
+            return *physical_a != -1;
+        }
+    }
+    return false;
+}
+
+bool copyVirtual(PageTable *pageTable, PhysicalMemory *memory, uint32_t source_pid, int source_address,
+                 uint32_t destination_pid, int destination_address, long length) {
+    int page_size = pageTable->getPageSize();
+    long done = 0;
+    while (done < length) {
+        long source_offset = source_address + done;
+        long destination_offset = destination_address + done;
+        long segment = std::min(page_size - source_offset % page_size, page_size - destination_offset % page_size);
+        segment = std::min(segment, length - done);
+        // translate the destination first, a write to a shared frame may give it a copy
+        long destination_physical;
+        long source_physical;
+        if (!translatePair(pageTable, destination_pid, destination_offset, true, source_pid, source_offset, false,
+                           &destination_physical, &source_physical)) {
+            return false;
+        }
+        uint8_t *destination = memory->access(destination_physical, segment, true);
+        uint8_t *source = memory->access(source_physical, segment, false);
+        if (destination == NULL || source == NULL) {
+            return false;
+        }
+        // a variable copied onto itself, or onto a segment shared with it, is in the same frame
+        std::memmove(destination, source, segment);
+        done += segment;
+    }
+    return true;
+}
+
+bool compareVirtual(PageTable *pageTable, PhysicalMemory *memory, uint32_t pid_a, int address_a, uint32_t pid_b,
+                    int address_b, long length, long *difference) {
+    int page_size = pageTable->getPageSize();
+    *difference = -1;
+    long done = 0;
+    while (done < length) {
+        long offset_a = address_a + done;
+        long offset_b = address_b + done;
+        long segment = std::min(page_size - offset_a % page_size, page_size - offset_b % page_size);
+        segment = std::min(segment, length - done);
+        long physical_a;
+        long physical_b;
+        if (!translatePair(pageTable, pid_a, offset_a, false, pid_b, offset_b, false, &physical_a, &physical_b)) {
+            return false;
+        }
+        uint8_t *data_a = memory->access(physical_a, segment, false);
+        uint8_t *data_b = memory->access(physical_b, segment, false);
+        if (data_a == NULL || data_b == NULL) {
+            return false;
+        }
+        if (std::memcmp(data_a, data_b, segment) != 0) {
+            // only the segment that differs is looked at byte by byte
+            long i = 0;
+            while (data_a[i] == data_b[i]) {
+                i++;
+            }
+            *difference = done + i;
+            return true;
+        }
+        done += segment;
+    }
+    return true;
+}
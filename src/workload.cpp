@@ -0,0 +1,130 @@
+#include "workload.h"
+#include "virtualcopy.h"
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// Processes each client thread keeps running
+const int processes_per_thread = 4;
+// Variables a process may have on its heap before the thread starts freeing them
+const int variables_per_process = 32;
+
+typedef struct WorkloadProcess {
+    int pid;
+    std::vector<std::string> variables;
+} WorkloadProcess;
+
+typedef struct WorkloadCounters {
+    long allocations;
+    long failed_allocations;
+    long reads;
+    long frees;
+    long terminations;
+} WorkloadCounters;
+
+static uint64_t nextRandom(uint64_t *state) {
+    // xorshift64
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int createWorkloadProcess(Simulator *sim) {
+    int pid = sim->mmu->createProcess();
+    addVariable(pid, "<TEXT>", 4096, TYPE_CHAR, sim->mmu, sim->pageTable, sim->page_size);
+    addVariable(pid, "<GLOBALS>", 512, TYPE_CHAR, sim->mmu, sim->pageTable, sim->page_size);
+    addVariable(pid, "<STACK>", 65536, TYPE_CHAR, sim->mmu, sim->pageTable, sim->page_size);
+    return pid;
+}
+
+static void runClient(Simulator *sim, int core, int thread, long operations, WorkloadCounters *counters) {
+    PageTable::setCore(core);
+    uint64_t state = 0x9e3779b97f4a7c15ULL * (thread + 1);
+    char buffer[4096];
+    long next_name = 0;
+
+    WorkloadProcess processes[processes_per_thread];
+    for (int i = 0; i < processes_per_thread; i++) {
+        processes[i].pid = createWorkloadProcess(sim);
+    }
+
+    for (long op = 0; op < operations; op++) {
+        WorkloadProcess *process = &processes[nextRandom(&state) % processes_per_thread];
+        uint64_t choice = nextRandom(&state) % 100;
+
+        if (choice < 1) {
+            // process exits and a new one takes its place
+            terminate(process->pid, sim->mmu, sim->pageTable, sim->page_size);
+            process->pid = createWorkloadProcess(sim);
+            process->variables.clear();
+            counters->terminations++;
+        } else if (process->variables.empty() || (choice < 40 && process->variables.size() < variables_per_process)) {
+            // allocate and fill a new variable
+            std::string name = "v" + std::to_string(next_name++);
+            int size = 1 + nextRandom(&state) % sizeof(buffer);
+            int address = addVariable(process->pid, name, size, TYPE_CHAR, sim->mmu, sim->pageTable, sim->page_size);
+            if (address == -1) {
+                counters->failed_allocations++;
+                continue;
+            }
+            process->variables.push_back(name);
+            memset(buffer, (int)op, size);
+            copyToVirtual(sim->pageTable, sim->memory, process->pid, address, buffer, size);
+            counters->allocations++;
+        } else if (choice < 80) {
+            // read a variable back
+            Variable *variable = sim->mmu->getVariableFromProcess(process->pid,
+                    process->variables[nextRandom(&state) % process->variables.size()]);
+            copyFromVirtual(sim->pageTable, sim->memory, process->pid, variable->virtual_address, buffer,
+                            variable->size);
+            counters->reads++;
+        } else {
+            // free a variable
+            int index = nextRandom(&state) % process->variables.size();
+            free(process->pid, process->variables[index], sim->mmu, sim->pageTable, sim->page_size);
+            process->variables[index] = process->variables.back();
+            process->variables.pop_back();
+            counters->frees++;
+        }
+    }
+
+    for (int i = 0; i < processes_per_thread; i++) {
+        terminate(processes[i].pid, sim->mmu, sim->pageTable, sim->page_size);
+    }
+}
+
+/*
+ * Runs operations operations on each of the cores, one client thread per core, and prints the throughput
+ */
+void runConcurrentWorkload(Simulator *sim, const std::vector<int> &cores, long operations) {
+    std::vector<std::thread> threads;
+    std::vector<WorkloadCounters> counters(cores.size(), WorkloadCounters());
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < cores.size(); i++) {
+        threads.push_back(std::thread(runClient, sim, cores[i], i, operations, &counters[i]));
+    }
+    for (int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    WorkloadCounters total = WorkloadCounters();
+    for (int i = 0; i < counters.size(); i++) {
+        total.allocations += counters[i].allocations;
+        total.failed_allocations += counters[i].failed_allocations;
+        total.reads += counters[i].reads;
+        total.frees += counters[i].frees;
+        total.terminations += counters[i].terminations;
+    }
+    long total_operations = operations * cores.size();
+    std::cout << "Threads:      " << cores.size() << '\n';
+    std::cout << "Operations:   " << total_operations << " (" << total.allocations << " allocations, "
+              << total.failed_allocations << " failed, " << total.reads << " reads, " << total.frees << " frees, "
+              << total.terminations << " terminations)" << '\n';
+    std::cout << "Elapsed:      " << elapsed.count() << " s" << '\n';
+    std::cout << "Throughput:   " << (long)(elapsed.count() > 0 ? total_operations / elapsed.count() : 0)
+              << " operations/s" << '\n';
+}